@@ -0,0 +1,132 @@
+
+/*********************************************************************
+ *
+ * hazard.c - moving hazards on the board of hectic, see hazard.h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "hazard.h"
+#include "level.h"
+
+struct hazards_t hazards;
+uint64_t *hazard_at, *chaser_at;
+
+int level_hazards(int n, int level) {
+  return (n+2*(level-1))*scale;
+}
+
+/* make room for n hazards */
+static bool grow(int n) {
+  struct hazards_t *h = &hazards;
+  short *x, *y;
+  signed char *dx, *dy;
+  unsigned char *kind;
+
+  if (n <= h->room) return true;
+  if ((x = realloc(h->x,(size_t)n*sizeof(*x))) != NULL) h->x = x;
+  if ((y = realloc(h->y,(size_t)n*sizeof(*y))) != NULL) h->y = y;
+  if ((dx = realloc(h->dx,(size_t)n)) != NULL) h->dx = dx;
+  if ((dy = realloc(h->dy,(size_t)n)) != NULL) h->dy = dy;
+  if ((kind = realloc(h->kind,(size_t)n)) != NULL) h->kind = kind;
+  if (!x || !y || !dx || !dy || !kind) return false;
+  h->room = n;
+  return true;
+}
+
+bool place_hazards(int n) {
+  struct hazards_t *h = &hazards;
+  int tries, c, x, y, p;
+
+  if (hazard_at == NULL) {
+    hazard_at = malloc(words*sizeof(uint64_t));
+    chaser_at = malloc(words*sizeof(uint64_t));
+    if (hazard_at == NULL || chaser_at == NULL) return false;
+  }
+  if (!grow(n)) return false;
+  memset(hazard_at,0,words*sizeof(uint64_t));
+  memset(chaser_at,0,words*sizeof(uint64_t));
+
+  /* random free cells, as many as are found */
+  h->n = 0;
+  for (tries=0;h->n<n && tries<16*n;tries++) {
+    c = random_below(cells);
+    x = c%width;
+    y = c/width;
+    p = AT(x,y);
+    if (board[p] != EMPTY || TEST(hazard_at,p)
+	|| (abs(x-player.x) <= 3 && abs(y-player.y) <= 3))
+      continue;
+    h->x[h->n] = (short)x;
+    h->y[h->n] = (short)y;
+    SET(hazard_at,p);
+    if (h->n%4 == 3) {
+      h->kind[h->n] = CHASER;
+      h->dx[h->n] = h->dy[h->n] = 0;
+      SET(chaser_at,p);
+    } else {
+      h->kind[h->n] = BOUNCER;
+      do {
+	h->dx[h->n] = (signed char)(random_below(3)-1);
+	h->dy[h->n] = (signed char)(random_below(3)-1);
+      } while (h->dx[h->n] == 0 && h->dy[h->n] == 0);
+    }
+    h->n++;
+  }
+  return true;
+}
+
+/* true, if a hazard can't go to cell p */
+#define BLOCKED(p)	(TEST(wall,p) || TEST(hazard_at,p))
+
+int move_hazards(long tick) {
+  struct hazards_t *h = &hazards;
+  int pp = AT(player.x,player.y);
+  int lost = 0, i, p, q, tx, ty;
+  signed char dx, dy;
+
+  if (player.dx == 0 && player.dy == 0) return 0;	/* not started yet */
+  if (TEST(hazard_at,pp)) lost++;	/* the player ran into one */
+
+  for (i=0;i<h->n;i++) {
+    p = AT(h->x[i],h->y[i]);
+    if (h->kind[i] == CHASER) {
+      if (tick%2 != 0) continue;
+      tx = player.x-h->x[i];
+      ty = player.y-h->y[i];
+      dx = (signed char)((tx > 0)-(tx < 0));
+      dy = (signed char)((ty > 0)-(ty < 0));
+      if (abs(tx) >= abs(ty)) {
+	if (BLOCKED(p+dx) && dy != 0) dx = 0; else dy = 0;
+      } else {
+	if (BLOCKED(p+dy*stride) && dx != 0) dy = 0; else dx = 0;
+      }
+    } else {
+      dx = h->dx[i];
+      dy = h->dy[i];
+      if (dx != 0 && TEST(wall,p+dx)) dx = (signed char)-dx;
+      if (dy != 0 && TEST(wall,p+dy*stride)) dy = (signed char)-dy;
+    }
+    if (dx == 0 && dy == 0) continue;
+
+    /* into the player or something else: no step, a bouncer turns */
+    q = p+dx+dy*stride;
+    if (q == pp || BLOCKED(q)) {
+      if (q == pp) lost++;
+      h->dx[i] = (signed char)-dx;
+      h->dy[i] = (signed char)-dy;
+      continue;
+    }
+    CLEAR(hazard_at,p);
+    SET(hazard_at,q);
+    if (h->kind[i] == CHASER) {
+      CLEAR(chaser_at,p);
+      SET(chaser_at,q);
+    }
+    h->x[i] = (short)(h->x[i]+dx);
+    h->y[i] = (short)(h->y[i]+dy);
+    h->dx[i] = dx;
+    h->dy[i] = dy;
+  }
+  return lost;
+}
@@ -0,0 +1,51 @@
+
+/*********************************************************************
+ *
+ * hazard.h - moving hazards on the board of hectic, for -m
+ *
+ * A hazard runs around on its own and costs the player one energy
+ * whenever they touch: when the player runs into it or it runs into the
+ * player. Bouncers go straight, also diagonally, and bounce off walls
+ * and other hazards. Chasers step towards the player every second tick,
+ * on the axis with the longer way first. Nothing moves before the
+ * player does.
+ *
+ * Hazards aren't in board[], they pass over items and leave them. They
+ * are kept as a structure of arrays, and the cells they are on in
+ * bitsets over the cells of board[], so a tick is one pass over the
+ * arrays with a look into the wall and hazard bitsets per hazard, no
+ * matter how large the board is.
+ */
+
+#ifndef HAZARD_H
+#define HAZARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum { BOUNCER, CHASER };
+
+extern struct hazards_t {
+  int n;			/* on the board */
+  int room;			/* allocated */
+  short *x, *y;
+  signed char *dx, *dy;		/* -1, 0 or 1 */
+  unsigned char *kind;		/* BOUNCER or CHASER */
+} hazards;
+
+extern uint64_t *hazard_at;		/* cells with a hazard */
+extern uint64_t *chaser_at;		/* cells with a chaser */
+
+/* the hazards of a level number for -m n: n and 2 more with every
+   level, scaled like the blocks */
+int level_hazards(int n, int level);
+
+/* put up to n hazards on free cells of the current level, away from
+   the player, every fourth a chaser. False if out of memory. */
+bool place_hazards(int n);
+
+/* one step of all hazards after the player's step, returns the energy
+   lost */
+int move_hazards(long tick);
+
+#endif
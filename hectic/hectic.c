@@ -5,6 +5,11 @@
  *
  * 1.0	2000-06	initial version
  * 1.1  2014-12	refactored, instructions in game
+ * 1.2  2026-10	levels are built reachable, no more retries,
+ *		steady ticks, options -t and -s, board size set by -b,
+ *		autopilot demo -d, levels from a pack by -p,
+ *		recording -w and replay -r, latency histograms,
+ *		moving hazards -m
  *
  * Copyright (c) 2004+2014 Derik van Zuetphen <dz@426.ch>
  * All rights reserved.
@@ -36,16 +41,23 @@
  */
 
 
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>
 #include <ncurses.h>
+#include <poll.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
-
-static struct player_t {
-  int x,y;			/* player position */
-  int dx,dy;			/* player speed */
-} player;
+#include "hazard.h"
+#include "hist.h"
+#include "level.h"
+#include "pack.h"
+#include "plan.h"
+#include "record.h"
 
 static struct game_t {
   int score;
@@ -53,36 +65,51 @@ static struct game_t {
   int turn;			/* number of current turn */
   int blocks;			/* number of wall segments on the board */
   int level;
+  double tick;			/* seconds between two steps */
   bool end;			/* boolean for end-of-game */
 } game;
 
+/* timing, set by the command line */
+#define MIN_TICK 0.02
+static double start_tick = 0.15;	/* seconds per step in level 1 */
+static int speedup = 0;			/* % shorter steps in every level */
+
+/* the autopilot of the demo, a key takes over */
+static bool demo = false;
+static struct plan_t plan;
+static int planned;			/* steps of the plan done */
+
+/* levels from a pack of hecticpack, if there is one */
+static const struct pack_header_t *pack = NULL;
+
+/* moving hazards, see hazard.h */
+static int hazard_base = 0;		/* -m, hazards in level 1 */
+static struct hist_t hazard_hist;	/* time of move_hazards() per tick */
+static double hazard_seconds;		/* all of it */
+static double hazard_moves;		/* hazards moved */
+
+/* recording and replay, see record.h */
+static unsigned seed;			/* of the game */
+static long ticks;			/* steps since the start of the game */
+static const char *record_path = NULL;	/* record the game into it */
+static bool record_lost = false;	/* out of memory while recording */
+static const struct record_header_t *replay = NULL;
+static bool headless = false;		/* replay without curses */
+static double speed = 1;		/* replay that much faster */
+static long replay_tick;		/* of the next event */
+static int replay_key;
+static bool replay_more;		/* there is a next event */
+static bool replay_cut;			/* the recording ended before the game */
+
 #define XOFS	2		/* screen offset of the board */
 #define YOFS	4
 
-/* constants for elements on the board */
-enum itemtype_t {
-  EMPTY,
-  WALL,
-  PLAYER,
-  ITEM0,
-  VISITED=0x80};		/* flag for not reachable */
-
-/* the board */
-#define WIDTH 37
-#define HEIGHT 19
-static enum itemtype_t board[WIDTH][HEIGHT];
-
-/* the items */
-struct item_t {
-  int val;			/* score for this type of item */
-  char *ch;			/* char to display this item */
-  int num;			/* number of items of this type */
-};
-
-#define ITEMS	3
-static struct item_t item[ITEMS];
-static int cur_items;			/* number of items on the board */
-static int count_items;		/* temporary for fill_board() */
+/* the part of the board on the screen */
+static int view_x = -1, view_y = -1;	/* top left cell */
+static int view_w, view_h;		/* cells */
+static unsigned char *shown;		/* of every cell of the view, 0xff unknown */
+#define SHOW_BOUNCER	0xfd		/* hazards in shown[] */
+#define SHOW_CHASER	0xfe
 
 /* colors */
 enum {
@@ -92,6 +119,7 @@ enum {
   P_TITLE,
   P_GAMEOVER_FRAME,
   P_GAMEOVER_TEXT,
+  P_HAZARD,
   P_ITEM0
 };
 
@@ -100,83 +128,21 @@ extern int ninst;
 extern char *inst[];
 
 /************************************************************************
- * fill the board with "visited" places (starting at player position)
- * and increment cur_item on any item found
- * thus cur_items==ITEMS, if all items are reachable
- */
-
-static void fill_board(int x,int y) {
-  /* stop criterium */
-  if ((x<0)||(x>=WIDTH)||(y<0)||(y>=HEIGHT)) return;
-  if ((board[x][y]&VISITED) || (board[x][y] == WALL)) return;
-
-  /* test if item found and mark as visited */
-  if ((board[x][y] >= PLAYER) && board[x][y] < ITEM0+ITEMS) count_items++;
-  board[x][y] |= VISITED;
-
-  /* visit all 4 neighbors */
-  fill_board(x-1,y);
-  fill_board(x+1,y);
-  fill_board(x,y-1);
-  fill_board(x,y+1);
-}
-
-/************************************************************************
- * initialise the board according to global variables
+ * the board of the current level, from the pack as long as it has the
+ * level. Returns false, if the level doesn't fit on the board.
  */
 
-static void place_items() {
-  int i,j, x,y;
-  /* repeat all the placement operations until all items are reachable */
-  do {
+static bool next_level() {
+  bool fits = (pack != NULL && game.level <= (int)pack->levels
+	       && pack_load(pack_record(pack,game.level,random_below((int)pack->variants))))
+    || place_items(game.blocks);
 
-    /* clear board */
-    for (x=0;x<WIDTH;x++) {
-      for (y=0;y<HEIGHT;y++) {
-	board[x][y] = EMPTY;
-      }
-    }
-
-    /* items */
-    cur_items = 0;
-    for (i=0;i<ITEMS;i++) {
-      cur_items += item[i].num;
-      for (j=0;j<item[i].num;j++) {
-	do {
-	  x = rand()%WIDTH;
-	  y = rand()%HEIGHT;
-	} while (board[x][y]!=EMPTY);
-	board[x][y] = ITEM0+i;
-      }
-    }
-
-    /* blocks */
-    for (i=0;i<game.blocks;i++) {
-      do {
-	x = rand()%WIDTH;
-	y = rand()%HEIGHT;
-      } while (board[x][y]!=EMPTY);
-      board[x][y] = WALL;
-    }
-
-    /* player */
-    do {
-      player.x = rand()%WIDTH;
-      player.y = rand()%HEIGHT;
-    } while (board[player.x][player.y]!=EMPTY);
-    board[player.x][player.y] = PLAYER;
-    player.dx = player.dy = 0;
-
-    /* check for reachability */
-    count_items=0;
-    fill_board(player.x,player.y);
-    /* clear not-visited-flag */
-    for (x=0;x<WIDTH;x++) {
-      for (y=0;y<HEIGHT;y++) {
-	board[x][y] &= ~VISITED;
-      }
-    }
-  } while(count_items!=cur_items+1);
+  if (fits && hazard_base > 0 && !place_hazards(level_hazards(hazard_base,game.level))) {
+    if (!headless) endwin();
+    fprintf(stderr,"hectic: out of memory\n");
+    exit(1);
+  }
+  return fits;
 }
 
 /************************************************************************
@@ -185,21 +151,20 @@ static void place_items() {
 
 static void init_game() {
   /* variables */
-  item[0].val = 10; item[0].ch = "<>"; item[0].num = 10;
-  item[1].val = 20; item[1].ch = "::"; item[1].num = 5;
-  item[2].val = 50; item[2].ch = "$$"; item[2].num = 1;
+  init_items();
 
   game.turn = 0;
   game.score = 0;
   game.rest = 0;
-  game.blocks = 20;
   game.level = 1;
+  game.blocks = level_blocks(game.level);
+  game.tick = start_tick;
   game.end = false;
 
-  srand((unsigned)time(NULL));
+  srand(seed);
 
   /* board */
-  place_items();
+  if (!next_level()) game.end = true;
 }
 
 static void set_getch_blocking(bool flag) {
@@ -223,21 +188,42 @@ static void init_curses() {
   init_pair((short)P_TITLE,          COLOR_CYAN,    BG);
   init_pair((short)P_GAMEOVER_FRAME, COLOR_YELLOW,  BG);
   init_pair((short)P_GAMEOVER_TEXT,  COLOR_WHITE,   BG);
+  init_pair((short)P_HAZARD,         COLOR_WHITE,   COLOR_RED);
   init_pair((short)P_ITEM0,          COLOR_GREEN,   BG);
   init_pair((short)P_ITEM0+1,        COLOR_MAGENTA, BG);
   init_pair((short)P_ITEM0+2,        COLOR_RED,     BG);
+
+  /* the screen shows the board from column XOFS-2 and line YOFS-1 on */
+  view_w = (COLS-XOFS+2)/2;
+  view_h = LINES-YOFS+1;
+  if ((shown = malloc((size_t)view_w*view_h)) == NULL) {
+    endwin();
+    fprintf(stderr,"hectic: out of memory\n");
+    exit(1);
+  }
 }
 
 /************************************************************************
  * display one position of the board
  */
 
-static void display(int x,int y) {
-  int xx,yy,i;
-  xx = 2*x + XOFS;
-  yy = y + YOFS;
+/* what a cell shows, a hazard is on top of all but the player */
+static int cell(int x, int y) {
+  int p = AT(x,y);
+
+  if (hazards.n > 0 && TEST(hazard_at,p) && board[p] != PLAYER)
+    return TEST(chaser_at,p) ? SHOW_CHASER : SHOW_BOUNCER;
+  return board[p];
+}
+
+static void draw(int x,int y) {
+  int xx,yy,i,c;
+
+  if (x<view_x || x>=view_x+view_w || y<view_y || y>=view_y+view_h) return;
+  xx = 2*(x-view_x) + XOFS-2;
+  yy = y-view_y + YOFS-1;
 
-  switch (board[x][y]) {
+  switch (c = cell(x,y)) {
   case EMPTY:
     mvprintw(yy,xx,"  ");
     break;
@@ -251,8 +237,13 @@ static void display(int x,int y) {
     color_set(P_PLAYER,NULL);
     mvprintw(yy,xx,"@@");
     break;
+  case SHOW_BOUNCER:
+  case SHOW_CHASER:
+    color_set(P_HAZARD,NULL);
+    mvprintw(yy,xx,c == SHOW_CHASER ? "##" : "**");
+    break;
   default:
-    i=board[x][y]-ITEM0;
+    i=c-ITEM0;
     if ((i>=0)&&(i<ITEMS)) {
       color_set((short)(P_ITEM0+i),NULL);
       mvprintw(yy,xx,"%s",item[i].ch);
@@ -260,53 +251,162 @@ static void display(int x,int y) {
       mvprintw(yy,xx,"%c?",64+i);
     }
   }
-  move(0,0);
-  refresh();
 }
 
 /************************************************************************
- * display the whole board
+ * move the view, if the player comes near its edge. A board larger
+ * than the screen scrolls by half a screen. Returns true, if the view
+ * has moved.
  */
 
-static void display_board() {
+static int follow1(int view, int size, int board_size, int pos) {
+  if (size>=board_size+2) return -1;
+  if (pos>=view+2 && pos<view+size-2) return view;
+  view = pos-size/2;
+  if (view<-1) view = -1;
+  if (view>board_size+1-size) view = board_size+1-size;
+  return view;
+}
+
+static bool follow() {
+  int x = follow1(view_x,view_w,width,player.x);
+  int y = follow1(view_y,view_h,height,player.y);
+
+  if (x==view_x && y==view_y) return false;
+  view_x = x;
+  view_y = y;
+  return true;
+}
+
+/************************************************************************
+ * Rendering: the draw functions only draw into stdscr. render() draws
+ * the cells and status fields that differ from what the screen shows,
+ * frame() sends what changed to the terminal in one go, once per tick.
+ */
+
+static int shown_level, shown_blocks;	/* of the status line, -1 unknown */
+static int shown_rest, shown_score;
+
+static long frames;			/* sent to the terminal */
+static long frame_bytes;		/* their size, -1 if unknown */
+static long max_frame_bytes;
+static bool stats = false;		/* print them at the end */
+
+/* how responsive the game is, see run() */
+static struct hist_t key_hist;		/* from getch() to the frame of the move */
+static struct hist_t interval_hist;	/* between two steps */
+static struct hist_t late_hist;		/* of a step after its time */
+static double key_time = -1;		/* getch() of the key being handled */
+static double waiting = -1;		/* of the first key not on the screen */
+static bool show_timing = false;	/* live, toggled by the hidden key v */
+static char shown_timing[128];
+
+/* bytes written by the process so far, from /proc/self/io of Linux;
+   -1 elsewhere */
+static long bytes_written() {
+  static int fd = -2;
+  char buf[1024];
+  char *w;
+  ssize_t n;
+
+  if (fd == -2) fd = open("/proc/self/io",O_RDONLY);
+  if (fd < 0 || lseek(fd,0,SEEK_SET) < 0) return -1;
+  if ((n = read(fd,buf,sizeof(buf)-1)) <= 0) return -1;
+  buf[n] = 0;
+  w = strstr(buf,"wchar:");
+  return w ? atol(w+6) : -1;
+}
+
+static void frame() {
+  long before, bytes;
+
+  if (!is_wintouched(stdscr)) return;
+  before = bytes_written();
+  move(0,0);
+  wnoutrefresh(stdscr);
+  doupdate();
+  bytes = bytes_written()-before;
+
+  frames++;
+  if (before < 0 || frame_bytes < 0) {
+    frame_bytes = -1;
+  } else {
+    frame_bytes += bytes;
+    if (bytes > max_frame_bytes) max_frame_bytes = bytes;
+  }
+}
+
+static void render() {
+  unsigned char *s = shown;
   int x,y;
-  clear();
 
-  /* title */
-  color_set(P_TITLE,NULL);
-  mvprintw(0,0,"H e c t i c");
-  mvprintw(0,56,"[ ? for instructions ]");
-  refresh();
+  for (y=view_y;y<view_y+view_h;y++) {
+    for (x=view_x;x<view_x+view_w;x++,s++) {
+      if (x<=width && y<=height && *s != cell(x,y)) {
+	*s = (unsigned char)cell(x,y);
+	draw(x,y);
+      }
+    }
+  }
 
-  /* board */
-  color_set(P_WALL,NULL);
-  for (x=-1;x<=WIDTH;x++) {
-    attron(A_REVERSE);
-    mvprintw(YOFS-1,XOFS+2*x,"  ");
-    attroff(A_REVERSE);
+  color_set(P_TITLE,NULL);
+  if (game.level != shown_level || game.blocks != shown_blocks) {
+    mvprintw(2,0,"Level %d  Blocks %d", game.level, game.blocks);
+    shown_level = game.level;
+    shown_blocks = game.blocks;
+  }
+  if ((game.rest<0?0:game.rest) != shown_rest) {
+    shown_rest = game.rest<0?0:game.rest;
+    mvprintw(2,56,"Energy %3d", shown_rest);
+  }
+  if (game.score != shown_score) {
+    mvprintw(2,68,"Gold %5d", game.score);
+    shown_score = game.score;
   }
 
-  for (y=0;y<HEIGHT;y++) {
-    attron(A_REVERSE);
-    mvprintw(YOFS+y,XOFS-2,"  ");
-    color_set(P_WALL,NULL);
-    attroff(A_REVERSE);
-    for (x=0;x<WIDTH;x++) {
-      display(x,y);
+  if (show_timing) {
+    char line[sizeof(shown_timing)];
+    sprintf(line,"ms p50/p99/max  key %.1f/%.1f/%.1f  tick late %.1f/%.1f/%.1f",
+	    1e3*hist_value(&key_hist,0.5),1e3*hist_value(&key_hist,0.99),
+	    1e3*key_hist.max,1e3*hist_value(&late_hist,0.5),
+	    1e3*hist_value(&late_hist,0.99),1e3*late_hist.max);
+    if (strcmp(line,shown_timing) != 0) {
+      mvprintw(1,0,"%s",line);
+      clrtoeol();
+      strcpy(shown_timing,line);
     }
-    attron(A_REVERSE);
-    color_set(P_WALL,NULL);
-    mvprintw(YOFS+y,XOFS+2*WIDTH,"  ");
-    attroff(A_REVERSE);
   }
+}
 
-  color_set(P_WALL,NULL);
-  for (x=-1;x<=WIDTH;x++) {
-    attron(A_REVERSE);
-    mvprintw(YOFS+HEIGHT,XOFS+2*x,"  ");
-    attroff(A_REVERSE);
+static void toggle_timing() {
+  show_timing = !show_timing;
+  shown_timing[0] = 0;
+  if (!show_timing) {
+    move(1,0);
+    clrtoeol();
   }
-  refresh();
+}
+
+/************************************************************************
+ * display the whole board, as far as it is on the screen
+ */
+
+static void display_board() {
+  clear();
+
+  /* title */
+  color_set(P_TITLE,NULL);
+  mvprintw(0,0,"H e c t i c");
+  mvprintw(0,56,"[ ? for instructions ]");
+  if (demo) mvprintw(0,28,"A u t o p i l o t");
+
+  /* board and the ring of walls, all of it */
+  follow();
+  memset(shown,0xff,(size_t)view_w*view_h);
+  shown_level = shown_blocks = shown_rest = shown_score = -1;
+  shown_timing[0] = 0;
+  render();
+  frame();
 }
 
 /************************************************************************
@@ -319,7 +419,7 @@ static void show_instructions() {
   for (y=0;y<ninst;y++) {
     mvprintw(y,0,inst[y]);
   }
-  refresh();
+  frame();
 
   set_getch_blocking(true);
   getch();
@@ -330,97 +430,183 @@ static void show_instructions() {
 
 /************************************************************************
  * game loop. handle key press and events
+ *
+ * Keys are handled as soon as they arrive, the player moves once per
+ * tick. The loop sleeps in poll() until a key comes in or the next tick
+ * is due. Ticks are counted from a monotonic clock, so the time spent
+ * in a step doesn't add up, and a late tick is followed by the next one
+ * in time instead of a burst to catch up.
+ *
+ * For -v and the key v, a key is timed from getch() to the end of the
+ * frame of the next step, which shows the move, and every step from the
+ * time it was due and from the step before.
  */
 
-static void run() {
-  int c;
-  int oldx, oldy;
-  bool end_wish = false;
-  display_board();
-  while (cur_items > 0) {
-    c = getch();
-    switch (c) {
-    case ERR:
-      break;
-    case KEY_DOWN:
-    case 14:
-    case 'j':
-      player.dy = 1;
-      player.dx = 0;
-      break;
-    case KEY_UP:
-    case 16:
-    case 'k':
-      player.dy = -1;
-      player.dx = 0;
-      break;
-    case KEY_LEFT:
-    case 2:
-    case 'h':
-      player.dy = 0;
-      player.dx = -1;
-      break;
-    case KEY_RIGHT:
-    case 6:
-    case 'l':
-      player.dy = 0;
-      player.dx = 1;
-      break;
-    case 'q':
-      end_wish = true;
-      break;
-    case '?':
-      show_instructions();
-      break;
-    }
-    oldx = player.x;
-    oldy = player.y;
-    player.x += player.dx;
-    player.y += player.dy;
-
-    if (player.x < 0) {
-      player.x = 0;
-      game.rest--;
-    }
-    if (player.x >= WIDTH) {
-      player.x = WIDTH-1;
-      game.rest--;
-    }
-    if (player.y < 0) {
-      player.y = 0;
-      game.rest--;
-    }
-    if (player.y >= HEIGHT) {
-      player.y = HEIGHT-1;
-      game.rest--;
-    }
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
 
-    if (board[player.x][player.y] == WALL) {
-      game.rest--;
-      player.x = oldx;
-      player.y = oldy;
-    }
+/* a key that changes the game, it goes into the recording */
+static void press(int key) {
+  switch (key) {
+  case REC_DOWN:
+    player.dy = 1;
+    player.dx = 0;
+    break;
+  case REC_UP:
+    player.dy = -1;
+    player.dx = 0;
+    break;
+  case REC_LEFT:
+    player.dy = 0;
+    player.dx = -1;
+    break;
+  case REC_RIGHT:
+    player.dy = 0;
+    player.dx = 1;
+    break;
+  case REC_QUIT:
+    game.end = true;
+    break;
+  }
+  if (key != REC_QUIT && key_time >= 0 && waiting < 0) waiting = key_time;
+  if (record_path != NULL && !record_event(ticks,key)) record_lost = true;
+}
 
-    if (board[player.x][player.y] >= ITEM0) {
-      game.score += item[board[player.x][player.y]-ITEM0].val;
-      cur_items--;
-    }
+static void handle_key(int c) {
+  switch (c) {
+  case KEY_DOWN:
+  case 14:
+  case 'j':
+    press(REC_DOWN);
+    break;
+  case KEY_UP:
+  case 16:
+  case 'k':
+    press(REC_UP);
+    break;
+  case KEY_LEFT:
+  case 2:
+  case 'h':
+    press(REC_LEFT);
+    break;
+  case KEY_RIGHT:
+  case 6:
+  case 'l':
+    press(REC_RIGHT);
+    break;
+  case 'q':
+    press(REC_QUIT);
+    break;
+  case '?':
+    show_instructions();
+    break;
+  case 'v':
+    toggle_timing();
+    break;
+  }
+}
 
-    color_set(P_TITLE,NULL);
-    mvprintw(2,0,"Level %d  Blocks %d", game.level, game.blocks);
-    mvprintw(2,56,"Energy %3d  Gold %5d", game.rest<0?0:game.rest, game.score);
+/* the keys of the recording for this tick. A game still running at
+   the ticks recorded, or with no events left while the player stands
+   still, won't end as recorded: it ends here. */
+static void replay_keys() {
+  while (replay_more && replay_tick == ticks) {
+    press(replay_key);
+    replay_more = record_next(&replay_tick,&replay_key);
+  }
+  if (!game.end && (ticks >= (long)replay->ticks
+		    || (!replay_more && player.dx == 0 && player.dy == 0)))
+    game.end = replay_cut = true;
+}
 
-    board[oldx][oldy] = EMPTY;
-    board[player.x][player.y] = PLAYER;
+static void step() {
+  double t;
+
+  game.rest -= move_player(&game.score);
+  if (hazards.n > 0) {
+    t = now();
+    game.rest -= move_hazards(ticks);
+    t = now()-t;
+    hist_add(&hazard_hist,t);
+    hazard_seconds += t;
+    hazard_moves += hazards.n;
+  }
+  ticks++;
+  if (game.rest < 0) game.end = true;
+  if (headless) return;
+
+  follow();
+  render();
+  frame();
+  if (waiting >= 0) {
+    hist_add(&key_hist,now()-waiting);
+    waiting = -1;
+  }
+}
+
+static void run() {
+  struct pollfd in;
+  double next, left, t, got, last = -1;
+  int c;
 
-    display(oldx,oldy);
-    display(player.x,player.y);
+  if (headless) {
+    while (cur_items > 0 && !game.end) {
+      replay_keys();
+      if (!game.end) step();
+    }
+    return;
+  }
 
-    usleep(150000);
+  if (demo) {
+    planned = 0;
+    free_plan(&plan);
+    if (!make_plan(&plan)) demo = false;
+  }
+  display_board();
+  in.fd = STDIN_FILENO;
+  in.events = POLLIN;
+  next = now();
+  while (cur_items > 0 && !game.end) {
+    left = next-now();
+    if (left <= 0) {
+      if (replay != NULL)
+	replay_keys();
+      else if (demo && planned < plan.steps)
+	handle_key(plan.key[planned++]);
+      if (game.end) break;
+      t = now();
+      hist_add(&late_hist,t-next);
+      if (last >= 0) hist_add(&interval_hist,t-last);
+      last = t;
+      step();
+      next += game.tick/speed;
+      if (next < now()) next = now()+game.tick/speed;
+      continue;
+    }
 
-    if (game.rest < 0 || end_wish) {
-      game.end=true;
-      cur_items = 0;		/* force break of inner loop */
+    /* round up, waking early would only mean another poll */
+    if (poll(&in,1,(int)(left*1000)+1) <= 0) continue;
+    while (!game.end && (c = getch()) != ERR) {
+      got = now();
+      if (replay != NULL) {		/* only watching */
+	if (c == 'q') game.end = true;
+	if (c == 'v') toggle_timing();
+	continue;
+      }
+      if (demo && c != '?' && c != 'q' && c != 'v') {
+	demo = false;
+	display_board();
+      }
+      key_time = got;
+      handle_key(c);
+      key_time = -1;
+      if (c == '?') {			/* no catching up */
+	next = now()+game.tick/speed;
+	last = waiting = -1;
+      }
     }
   }
 }
@@ -455,18 +641,156 @@ void game_over(struct game_t *game) {
   getch();
 }
 
-int main() {
+static void usage() {
+  fprintf(stderr,"usage: hectic [-d] [-v] [-b WIDTHxHEIGHT|fit|-p pack] [-t ms] [-s percent]\n"
+	  "              [-m hazards] [-w recording | -r recording [-x speedup]]\n");
+  exit(1);
+}
+
+static void print_hist(const char *what, const struct hist_t *h) {
+  printf("%-14s%7ld, p50 %.2f, p90 %.2f, p99 %.2f, p99.9 %.2f, max %.2f\n",what,h->n,
+	 1e3*hist_value(h,0.5),1e3*hist_value(h,0.9),1e3*hist_value(h,0.99),
+	 1e3*hist_value(h,0.999),1e3*h->max);
+}
+
+/* the cost of the hazards per tick */
+static void print_hazards() {
+  long n = hazard_hist.n;
+
+  if (n == 0) return;
+  printf("hazards: %.0f per tick, %.2f us per tick, %.1f ns per hazard\n",
+	 hazard_moves/n,1e6*hazard_seconds/n,
+	 hazard_moves > 0 ? 1e9*hazard_seconds/hazard_moves : 0.0);
+  printf("hazards in us: p50 %.0f, p99 %.0f, p99.9 %.0f, max %.1f\n",
+	 1e6*hist_value(&hazard_hist,0.5),1e6*hist_value(&hazard_hist,0.99),
+	 1e6*hist_value(&hazard_hist,0.999),1e6*hazard_hist.max);
+}
+
+/* check the end of a replay against the recording */
+static int check_replay(double seconds) {
+  bool same = !replay_cut && game.score == replay->score && game.level == replay->level
+    && game.blocks == replay->blocks && ticks == (long)replay->ticks;
+
+  printf("replayed %ld ticks in %.3f s, %.0f ticks/s\n",
+	 ticks,seconds,seconds > 0 ? ticks/seconds : 0.0);
+  if (stats) print_hazards();
+  printf("score %d, level %d, blocks %d: %s\n",game.score,game.level,game.blocks,
+	 same ? "as recorded" : "different");
+  if (!same)
+    printf("recorded score %d, level %d, blocks %d in %u ticks\n",
+	   replay->score,replay->level,replay->blocks,replay->ticks);
+  return same ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  struct record_header_t rec;
+  bool full, fit = false, watch = false;
+  const char *error;
+  double start, seconds;
+  int c;
+
+  while ((c = getopt(argc,argv,"db:p:t:s:m:vw:r:x:")) != -1) {
+    switch (c) {
+    case 'd':
+      demo = true;
+      break;
+    case 'b':
+      if (strcmp(optarg,"fit") == 0)
+	fit = true;
+      else if (sscanf(optarg,"%dx%d",&width,&height) != 2
+	       || width < 1 || width > MAX_SIZE || height < 1 || height > MAX_SIZE)
+	usage();
+      break;
+    case 'p':
+      if ((pack = pack_open(optarg,&error)) == NULL) {
+	fprintf(stderr,"hectic: %s: %s\n",optarg,error);
+	return 1;
+      }
+      break;
+    case 't':
+      start_tick = atof(optarg)/1000;
+      break;
+    case 's':
+      speedup = atoi(optarg);
+      break;
+    case 'm':
+      hazard_base = atoi(optarg);
+      break;
+    case 'v':
+      stats = true;
+      break;
+    case 'w':
+      record_path = optarg;
+      break;
+    case 'r':
+      if ((replay = record_read(optarg,&error)) == NULL) {
+	fprintf(stderr,"hectic: %s: %s\n",optarg,error);
+	return 1;
+      }
+      break;
+    case 'x':
+      speed = atof(optarg);
+      watch = true;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind != argc || start_tick < MIN_TICK || speedup < 0 || speedup >= 100 || hazard_base < 0
+      || (replay != NULL && record_path != NULL) || (watch && replay == NULL) || speed <= 0)
+    usage();
+
+  /* a replay is started as the recorded game, -x shows it */
+  seed = (unsigned)time(NULL);
+  if (replay != NULL) {
+    if (replay->packed != (pack != NULL) || (pack != NULL && replay->pack_seed != pack->seed)) {
+      fprintf(stderr,"hectic: the recording needs %s\n",
+	      replay->packed ? "-p with the pack it was played from" : "no pack");
+      return 1;
+    }
+    seed = replay->seed;
+    width = replay->width;
+    height = replay->height;
+    start_tick = replay->tick_us/1e6;
+    speedup = (int)replay->speedup;
+    hazard_base = (int)replay->hazards;
+    fit = demo = false;
+    headless = !watch;
+    replay_more = record_next(&replay_tick,&replay_key);
+  }
+
+  if (!headless) init_curses();
+  if (pack != NULL) {
+    width = pack->width;
+    height = pack->height;
+  } else if (fit) {
+    width = view_w-2 > 1 ? view_w-2 : 1;
+    height = view_h-2 > 1 ? view_h-2 : 1;
+  }
+  if (!alloc_board()) {
+    if (!headless) endwin();
+    fprintf(stderr,"hectic: no memory for a %dx%d board\n",width,height);
+    return 1;
+  }
+  start = now();
   init_game();
-  init_curses();
+  full = game.end;
   while(!game.end) {
     run();
     if (game.end) break;
     game.turn++;
-    game.blocks += 8;
     game.rest += 10;
     game.level++;
-    place_items();
+    game.blocks = level_blocks(game.level);
+    game.tick *= (100-speedup)/100.0;
+    if (game.tick < MIN_TICK) game.tick = MIN_TICK;
+    if (!next_level()) {
+      full = true;
+      break;
+    }
   }
+  seconds = now()-start;
+  if (headless) return check_replay(seconds);
 
   game_over(&game);
 
@@ -475,8 +799,47 @@ int main() {
   refresh();
   endwin();
 
+  if (stats) {
+    printf("%ld ticks, %ld frames, ",ticks,frames);
+    if (frame_bytes >= 0)
+      printf("%ld bytes, %.0f bytes per frame, at most %ld\n",
+	     frame_bytes,frames ? (double)frame_bytes/frames : 0.0,max_frame_bytes);
+    else
+      printf("bytes unknown, counted on Linux only\n");
+    printf("times in ms, a tick of %.1f in level 1\n",1e3*start_tick/speed);
+    print_hist("key to screen",&key_hist);
+    print_hist("tick interval",&interval_hist);
+    print_hist("tick late",&late_hist);
+    if (replay == NULL) print_hazards();
+  }
+  if (replay != NULL) return check_replay(seconds);
+
   printf("Your final score: %d Gold in %d level%s with %d blocks\n",
 	 game.score, game.level, game.level>1?"s":"",game.blocks);
+  if (full)
+    printf("Level %d would need %d blocks, %d items and the player on %d cells\n",
+	   game.level, game.blocks, cur_items, cells);
+
+  if (record_path != NULL) {
+    memset(&rec,0,sizeof(rec));
+    rec.seed = seed;
+    rec.width = (uint16_t)width;
+    rec.height = (uint16_t)height;
+    rec.tick_us = (uint32_t)(start_tick*1e6+0.5);
+    rec.speedup = (uint32_t)speedup;
+    rec.hazards = (uint32_t)hazard_base;
+    rec.packed = pack != NULL;
+    rec.pack_seed = pack != NULL ? pack->seed : 0;
+    rec.score = game.score;
+    rec.level = game.level;
+    rec.blocks = game.blocks;
+    rec.ticks = (uint32_t)ticks;
+    if (record_lost || !record_write(record_path,&rec)) {
+      fprintf(stderr,"hectic: %s: the recording could not be %s\n",record_path,
+	      record_lost ? "kept, out of memory" : "written");
+      return 1;
+    }
+  }
 
   return 0;
 }
@@ -0,0 +1,139 @@
+
+/*********************************************************************
+ *
+ * hecticbench - speed of the hectic level generator by level
+ *
+ * Usage: hecticbench [-b WIDTHxHEIGHT] [-l levels] [-n boards] [-s seed]
+ *                    [-t seconds]
+ *
+ * Generates 'boards' boards (100 by default) for every level from 1 to
+ * 'levels' (100), each from a fixed seed made of -s, the level and the
+ * board, so two builds generate the same boards. For every level the
+ * counters of gen_stats and the time per board, median and 99th
+ * percentile, go to stdout as JSON, to compare generators.
+ *
+ * A level whose blocks and items don't fit on the board is reported as
+ * "impossible". A level that isn't done after -t seconds (10) is
+ * stopped and reported as "timeout", a failure that makes the exit
+ * status 1.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "level.h"
+
+static sigjmp_buf timeout;
+
+static void expired(int sig) {
+  (void)sig;
+  siglongjmp(timeout,1);
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static int compare(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void usage() {
+  fprintf(stderr,"usage: hecticbench [-b WIDTHxHEIGHT] [-l levels] [-n boards] [-s seed]\n"
+	  "                   [-t seconds]\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  struct sigaction sa;
+  unsigned seed = 1;
+  int levels = 100, boards = 100, limit = 10;
+  int level, i, c, ok = 0, impossible = 0, failures = 0;
+  const char *status;
+  double *t, start, total;
+  long visited;
+
+  while ((c = getopt(argc,argv,"b:l:n:s:t:")) != -1) {
+    switch (c) {
+    case 'b':
+      if (sscanf(optarg,"%dx%d",&width,&height) != 2
+	  || width < 1 || width > MAX_SIZE || height < 1 || height > MAX_SIZE)
+	usage();
+      break;
+    case 'l': levels = atoi(optarg); break;
+    case 'n': boards = atoi(optarg); break;
+    case 's': seed = (unsigned)strtoul(optarg,NULL,0); break;
+    case 't': limit = atoi(optarg); break;
+    default: usage();
+    }
+  }
+  if (optind != argc || levels < 1 || boards < 1 || limit < 1) usage();
+
+  if (!alloc_board() || (t = malloc((size_t)boards*sizeof(double))) == NULL) {
+    fprintf(stderr,"hecticbench: no memory for a %dx%d board\n",width,height);
+    return 1;
+  }
+  init_items();
+  memset(&sa,0,sizeof(sa));
+  sa.sa_handler = expired;
+  sigaction(SIGALRM,&sa,NULL);
+
+  printf("{\n");
+  printf("  \"board\": \"%dx%d\",\n",width,height);
+  printf("  \"seed\": %u,\n",seed);
+  printf("  \"boards\": %d,\n",boards);
+  printf("  \"levels\": [\n");
+  total = now();
+  for (level=1;level<=levels;level++) {
+    memset(&gen_stats,0,sizeof(gen_stats));
+    status = "ok";
+    if (sigsetjmp(timeout,1) == 0) {
+      alarm((unsigned)limit);
+      for (i=0;i<boards;i++) {
+	srand(seed*2654435761u+(unsigned)level*1000003u+(unsigned)i);
+	start = now();
+	if (!place_items(level_blocks(level))) {
+	  status = "impossible";
+	  break;
+	}
+	t[i] = now()-start;
+      }
+      alarm(0);
+    } else {
+      status = "timeout";
+    }
+
+    printf("    { \"level\": %d, \"blocks\": %d, \"status\": \"%s\"",
+	   level,level_blocks(level),status);
+    if (strcmp(status,"ok") == 0) {
+      ok++;
+      qsort(t,(size_t)boards,sizeof(double),compare);
+      visited = gen_stats.visited/gen_stats.boards;
+      printf(", \"visited\": %ld, \"depth\": %ld, "
+	     "\"leaves\": %ld, \"median_us\": %.1f, \"p99_us\": %.1f",
+	     visited,gen_stats.depth,
+	     gen_stats.leaves,1e6*t[boards/2],1e6*t[(boards*99+99)/100-1]);
+    } else if (strcmp(status,"impossible") == 0) {
+      impossible++;
+    } else {
+      failures++;
+    }
+    printf(" }%s\n",level < levels ? "," : "");
+  }
+  printf("  ],\n");
+  printf("  \"ok\": %d,\n",ok);
+  printf("  \"impossible\": %d,\n",impossible);
+  printf("  \"failures\": %d,\n",failures);
+  printf("  \"seconds\": %.3f\n",now()-total);
+  printf("}\n");
+  return failures > 0;
+}
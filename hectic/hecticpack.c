@@ -0,0 +1,168 @@
+
+/*********************************************************************
+ *
+ * hecticpack - generate a pack of hectic levels
+ *
+ * Usage: hecticpack [-b WIDTHxHEIGHT] [-l levels] [-n variants] [-j jobs]
+ *                   [-r seed] pack
+ *
+ * Generates 'variants' boards (100 by default) for every level number
+ * from 1 to 'levels', by default up to the last one that fits on the
+ * board, and writes them into a pack (see pack.h) for hectic -p. Every
+ * board is checked by loading it back from its record.
+ *
+ * The level generator keeps its board in global variables, so the jobs
+ * are processes: the pack is mapped shared, and job j writes the
+ * records j, j+jobs, j+2*jobs ... in place. Each record is generated
+ * from a seed of its own, so a pack depends only on -r and not on -j.
+ * The time each board took is kept in its record and printed per level.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "level.h"
+#include "pack.h"
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static void usage() {
+  fprintf(stderr,"usage: hecticpack [-b WIDTHxHEIGHT] [-l levels] [-n variants] [-j jobs]\n"
+	  "                  [-r seed] pack\n");
+  exit(1);
+}
+
+/* generate the records of job j, returns the exit status */
+static int work(struct pack_header_t *h, int j, int jobs) {
+  struct pack_record_t *r;
+  long i, n = (long)h->levels*h->variants;
+  int level;
+  double start;
+
+  for (i=j;i<n;i+=jobs) {
+    level = (int)(i/h->variants)+1;
+    srand(h->seed*2654435761u+(unsigned)i);
+    start = now();
+    if (!place_items(level_blocks(level))) return 1;
+    r = (struct pack_record_t *)pack_record(h,level,(int)(i%h->variants));
+    pack_store(r,level_blocks(level),now()-start);
+    if (!pack_load(r)) {
+      fprintf(stderr,"hecticpack: level %d, variant %ld is not valid\n",
+	      level,i%h->variants);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  struct pack_header_t *h;
+  const struct pack_record_t *r;
+  unsigned seed = (unsigned)time(NULL);
+  long levels = 0, variants = 100, jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  long j, level, v, done = 0;
+  size_t size;
+  double start, seconds, sum, max, all = 0;
+  int fd, status, c, i, items = 0, failed = 0;
+  pid_t pid;
+
+  while ((c = getopt(argc,argv,"b:l:n:j:r:")) != -1) {
+    switch (c) {
+    case 'b':
+      if (sscanf(optarg,"%dx%d",&width,&height) != 2
+	  || width < 1 || width > MAX_SIZE || height < 1 || height > MAX_SIZE)
+	usage();
+      break;
+    case 'l': levels = atol(optarg); break;
+    case 'n': variants = atol(optarg); break;
+    case 'j': jobs = atol(optarg); break;
+    case 'r': seed = (unsigned)strtoul(optarg,NULL,0); break;
+    default: usage();
+    }
+  }
+  if (argc-optind != 1 || levels < 0 || variants < 1 || jobs < 1) usage();
+
+  if (!alloc_board()) {
+    fprintf(stderr,"hecticpack: no memory for a %dx%d board\n",width,height);
+    return 1;
+  }
+  init_items();
+  for (i=0;i<ITEMS;i++) items += item[i].num;
+  if (levels == 0) {
+    while (cells-level_blocks((int)levels+1) >= items+1) levels++;
+  }
+
+  /* the pack, all of it mapped */
+  size = sizeof(*h)+(size_t)levels*(size_t)variants*pack_record_size();
+  if ((fd = open(argv[optind],O_RDWR|O_CREAT|O_TRUNC,0666)) < 0
+      || ftruncate(fd,(off_t)size) < 0
+      || (h = mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0)) == MAP_FAILED) {
+    perror(argv[optind]);
+    return 1;
+  }
+  close(fd);
+  memset(h,0,sizeof(*h));
+  memcpy(h->magic,PACK_MAGIC,sizeof(h->magic));
+  h->version = PACK_VERSION;
+  h->byte_order = 0x01020304;
+  h->record_size = (uint32_t)pack_record_size();
+  h->width = (uint16_t)width;
+  h->height = (uint16_t)height;
+  h->levels = (uint32_t)levels;
+  h->variants = (uint32_t)variants;
+  h->seed = seed;
+
+  start = now();
+  fflush(stdout);
+  for (j=0;j<jobs;j++) {
+    if ((pid = fork()) < 0) {
+      perror("hecticpack");
+      return 1;
+    }
+    if (pid == 0) _exit(work(h,(int)j,(int)jobs));
+  }
+  while (wait(&status) > 0) {
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = 1;
+  }
+  seconds = now()-start;
+  if (failed) {
+    fprintf(stderr,"hecticpack: a job failed, %s is not complete\n",argv[optind]);
+    return 1;
+  }
+
+  printf("board %dx%d, %ld levels of %ld, seed %u, %ld jobs\n\n",
+	 width,height,levels,variants,seed,jobs);
+  printf("level  blocks   mean us    max us\n");
+  for (level=1;level<=levels;level++) {
+    sum = max = 0;
+    for (v=0;v<variants;v++) {
+      r = pack_record(h,(int)level,(int)v);
+      sum += r->usec;
+      if (r->usec > max) max = r->usec;
+      done++;
+    }
+    all += sum;
+    printf("%5ld  %6d  %8.0f  %8.0f\n",level,level_blocks((int)level),sum/variants,max);
+  }
+  printf("\n%ld boards in %.2f s, %.0f boards/s, %.0f us per board and job\n",
+	 done,seconds,seconds > 0 ? done/seconds : 0.0,done ? all/done : 0.0);
+  printf("%s: %lu bytes, %u per board\n",argv[optind],(unsigned long)size,h->record_size);
+
+  if (msync(h,size,MS_SYNC) < 0) {
+    perror(argv[optind]);
+    return 1;
+  }
+  munmap(h,size);
+  return 0;
+}
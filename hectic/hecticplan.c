@@ -0,0 +1,98 @@
+
+/*********************************************************************
+ *
+ * hecticplan - rate the levels of hectic by the autopilot
+ *
+ * Usage: hecticplan [-b WIDTHxHEIGHT] [-l levels] [-r seed]
+ *
+ * Generates the levels as the game does, from level 1 on until the
+ * board is full or -l levels are done, and plans each of them (see
+ * plan.h). The plan is played by the rules of the game, the energy it
+ * loses is printed with the steps and turns it needs. "exact" plans
+ * are the shortest possible, the others go to the nearest item next.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "level.h"
+#include "plan.h"
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static void usage() {
+  fprintf(stderr,"usage: hecticplan [-b WIDTHxHEIGHT] [-l levels] [-r seed]\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  struct plan_t plan;
+  unsigned seed = (unsigned)time(NULL);
+  int levels = 0, level, blocks, lost, gold, i, c;
+  double start, seconds;
+
+  while ((c = getopt(argc,argv,"b:l:r:")) != -1) {
+    switch (c) {
+    case 'b':
+      if (sscanf(optarg,"%dx%d",&width,&height) != 2
+	  || width < 1 || width > MAX_SIZE || height < 1 || height > MAX_SIZE)
+	usage();
+      break;
+    case 'l':
+      levels = atoi(optarg);
+      break;
+    case 'r':
+      seed = (unsigned)strtoul(optarg,NULL,0);
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind != argc || levels < 0) usage();
+
+  if (!alloc_board()) {
+    fprintf(stderr,"hecticplan: no memory for a %dx%d board\n",width,height);
+    return 1;
+  }
+  init_items();
+  srand(seed);
+
+  printf("board %dx%d, seed %u\n\n",width,height,seed);
+  printf("level  blocks  items   steps   turns  lost        ms\n");
+  for (level=1;levels==0 || level<=levels;level++) {
+    blocks = level_blocks(level);
+    if (!place_items(blocks)) break;
+
+    start = now();
+    if (!make_plan(&plan)) {
+      fprintf(stderr,"hecticplan: no plan for level %d\n",level);
+      return 1;
+    }
+    seconds = now()-start;
+
+    /* play it */
+    printf("%5d  %6d  %5d  ",level,blocks,cur_items);
+    lost = gold = 0;
+    for (i=0;i<plan.steps && cur_items>0;i++) {
+      player.dx = plan.key[i]=='h' ? -1 : plan.key[i]=='l' ? 1 : 0;
+      player.dy = plan.key[i]=='k' ? -1 : plan.key[i]=='j' ? 1 : 0;
+      lost += move_player(&gold);
+    }
+    printf("%6d  %6d  %4d  %8.2f%s\n",plan.steps,plan.turns,lost,1000*seconds,
+	   plan.exact ? "  exact" : "");
+    if (cur_items>0) {
+      fprintf(stderr,"hecticplan: %d items left on level %d\n",cur_items,level);
+      return 1;
+    }
+    free_plan(&plan);
+  }
+  return 0;
+}
@@ -0,0 +1,56 @@
+
+/*********************************************************************
+ *
+ * hist.c - histograms of times, see hist.h
+ */
+
+#include "hist.h"
+
+#define SUB	(1<<HIST_SUB)
+
+/* the bucket of a time of us microseconds: below 2*SUB the time
+   itself, above that the highest bit e and the SUB bits below it */
+static int bucket(unsigned long us) {
+  int e = HIST_SUB+1;
+
+  if (us < 2*SUB) return (int)us;
+  while (us >> (e+1) != 0) e++;
+  return (e-HIST_SUB)*SUB+(int)(us >> (e-HIST_SUB));
+}
+
+/* the middle of bucket b in microseconds */
+static double middle(int b) {
+  int e, shift;
+
+  if (b < 2*SUB) return b;
+  e = b/SUB+HIST_SUB-1;
+  shift = e-HIST_SUB;
+  return (double)((unsigned long)(SUB+b%SUB) << shift) + (double)(1UL << shift)/2;
+}
+
+void hist_add(struct hist_t *h, double seconds) {
+  double us = seconds*1e6;
+
+  if (us < 0) us = 0;
+  if (us > 4294967295.0) us = 4294967295.0;
+  h->count[bucket((unsigned long)us)]++;
+  if (h->n == 0 || seconds > h->max) h->max = seconds;
+  h->n++;
+}
+
+double hist_value(const struct hist_t *h, double p) {
+  long rank, seen = 0;
+  double v;
+  int b;
+
+  if (h->n == 0) return 0;
+  rank = (long)(p*h->n+0.5);
+  if (rank < 1) rank = 1;
+  if (rank > h->n) rank = h->n;
+  for (b=0;b<HIST_BUCKETS;b++) {
+    seen += h->count[b];
+    if (seen >= rank) break;
+  }
+  v = middle(b)/1e6;
+  return v < h->max ? v : h->max;
+}
@@ -0,0 +1,32 @@
+
+/*********************************************************************
+ *
+ * hist.h - histograms of times
+ *
+ * A histogram counts times in microseconds with a relative error of
+ * at most 1/128, like a HDR histogram: times below 256 us have a bucket
+ * each, above that every power of two is split into 128 buckets, so a
+ * tick of 150 ms is known to 0.6 ms. Adding a time is a few shifts and
+ * no allocation, so it can be done in every tick of the game.
+ */
+
+#ifndef HIST_H
+#define HIST_H
+
+#define HIST_SUB	7		/* 2^HIST_SUB buckets per power of two */
+#define HIST_BUCKETS	((32-HIST_SUB+1)<<HIST_SUB)	/* up to 2^32 us */
+
+struct hist_t {
+  long n;			/* times added */
+  double max;			/* the largest, exactly, in seconds */
+  long count[HIST_BUCKETS];
+};
+
+/* add a time in seconds */
+void hist_add(struct hist_t *h, double seconds);
+
+/* the time in seconds that the fraction p of the times is not above,
+   0 if there are none */
+double hist_value(const struct hist_t *h, double p);
+
+#endif
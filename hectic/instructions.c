@@ -15,7 +15,7 @@ char *inst[] = {
     "After you start running you can't stop anymore.", /* 10 */
     "",
     "You must not run into the walls or into boxes. If you do, your energy",
-    "decreases.",
+    "decreases. So does every touch of a moving ** or ##, if there are any.",
     "",
     "If your energy runs out, the game is over.", /* 15 */
     "",
@@ -0,0 +1,256 @@
+
+/*********************************************************************
+ *
+ * level.c - the board of hectic, its generator and its rules
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "level.h"
+
+int width = 37, height = 19;
+int stride, cells, scale;
+unsigned char *board;
+uint64_t *wall, *seen;
+size_t words;
+struct player_t player;
+struct item_t item[ITEMS];
+int cur_items;
+struct gen_stats_t gen_stats;
+
+/************************************************************************
+ * allocate the board and what the level generator needs
+ */
+
+static unsigned char *tree;		/* see spanning_tree() */
+static int *parent, *edge, *region, *leaf;
+
+void size_board() {
+  stride = width+2;
+  cells = width*height;
+  scale = cells/(37*19) > 1 ? cells/(37*19) : 1;
+}
+
+bool alloc_board() {
+  size_t n;
+
+  size_board();
+  n = (size_t)stride*(height+2);
+  words = (n+63)/64;
+  board = malloc(n);
+  tree = malloc(n);
+  parent = malloc(n*sizeof(int));
+  edge = malloc(2*n*sizeof(int));
+  region = malloc(n*sizeof(int));
+  leaf = malloc(n*sizeof(int));
+  wall = malloc(words*sizeof(uint64_t));
+  seen = malloc(words*sizeof(uint64_t));
+  return board && tree && parent && edge && region && leaf && wall && seen;
+}
+
+int random_below(int n) {
+  return (int)(((unsigned long)rand()*((unsigned long)RAND_MAX+1)+(unsigned long)rand())
+	       % (unsigned long)n);
+}
+
+/************************************************************************
+ * count the items reachable from the player, without recursion: a
+ * depth first search on its own stack, the visited cells are marked in
+ * a bitset. The ring of walls keeps it on the board.
+ */
+
+int count_reachable() {
+  int *stack = leaf;		/* not needed after place_items() */
+  int dir[4];
+  int n = 0, top = 0, p, q, i;
+
+  dir[0] = -1; dir[1] = 1; dir[2] = -stride; dir[3] = stride;
+  memset(seen,0,words*sizeof(uint64_t));
+  p = AT(player.x,player.y);
+  SET(seen,p);
+  stack[top++] = p;
+  while (top>0) {
+    p = stack[--top];
+    gen_stats.visited++;
+    if (board[p]>=ITEM0) n++;
+    for (i=0;i<4;i++) {
+      q = p+dir[i];
+      if (!TEST(wall,q) && !TEST(seen,q)) {
+	SET(seen,q);
+	stack[top++] = q;
+      }
+    }
+    if (top>gen_stats.depth) gen_stats.depth = top;
+  }
+  return n;
+}
+
+/************************************************************************
+ * a random spanning tree of the board (Kruskal on shuffled edges),
+ * tree[p] has a bit for each direction the tree goes from cell p
+ */
+
+enum { LEFT=1, RIGHT=2, UP=4, DOWN=8 };
+
+static int find_root(int p) {
+  while (parent[p]!=p) {
+    parent[p] = parent[parent[p]];
+    p = parent[p];
+  }
+  return p;
+}
+
+static void spanning_tree() {
+  int p,q,e,i,j,x,y,n = 0;
+
+  for (p=0;p<stride*(height+2);p++) {
+    tree[p] = 0;
+    parent[p] = p;
+  }
+  /* 2*p: p to the right, 2*p+1: p downwards */
+  for (y=0;y<height;y++) {
+    for (x=0;x<width;x++) {
+      if (x<width-1) edge[n++] = 2*AT(x,y);
+      if (y<height-1) edge[n++] = 2*AT(x,y)+1;
+    }
+  }
+  for (i=n-1;i>0;i--) {
+    j = random_below(i+1);
+    e = edge[i];
+    edge[i] = edge[j];
+    edge[j] = e;
+  }
+
+  for (i=0;i<n;i++) {
+    p = edge[i]/2;
+    q = edge[i]%2 ? p+stride : p+1;
+    if (find_root(p)==find_root(q)) continue;
+    parent[find_root(p)] = find_root(q);
+    tree[p] |= edge[i]%2 ? DOWN : RIGHT;
+    tree[q] |= edge[i]%2 ? UP : LEFT;
+  }
+}
+
+/************************************************************************
+ * initialise the board with that many blocks
+ *
+ * The blocks are leaves of a random spanning tree, picked at random and
+ * cut off one after the other. What is left of the tree stays in one
+ * piece, so every cell that is not a wall can be reached from the
+ * player, and the leaves lie all over the board. The items are put on
+ * those cells, so no board is ever thrown away. Returns false, if
+ * blocks, items and player don't fit on the board.
+ */
+
+static int degree(int p) {
+  return (tree[p]&LEFT ? 1 : 0) + (tree[p]&RIGHT ? 1 : 0)
+    + (tree[p]&UP ? 1 : 0) + (tree[p]&DOWN ? 1 : 0);
+}
+
+bool place_items(int blocks) {
+  int nregion = 0, nleaf = 0;
+  int start,i,j,p,q,x,y;
+
+  cur_items = 0;
+  for (i=0;i<ITEMS;i++) cur_items += item[i].num;
+  if (blocks<0 || cells-blocks<cur_items+1) return false;
+
+  spanning_tree();
+  memset(board,WALL,(size_t)stride*(height+2));
+  memset(wall,0xff,words*sizeof(uint64_t));
+  for (y=0;y<height;y++) {
+    for (x=0;x<width;x++) {
+      board[AT(x,y)] = EMPTY;
+      CLEAR(wall,AT(x,y));
+    }
+  }
+
+  /* the player is never cut off; a tree of more than one cell has two
+     leaves at least, so there is always one to take */
+  start = AT(random_below(width),random_below(height));
+  for (y=0;y<height;y++) {
+    for (x=0;x<width;x++) {
+      if (AT(x,y)!=start && degree(AT(x,y))==1) leaf[nleaf++] = AT(x,y);
+    }
+  }
+  for (j=0;j<blocks;j++) {
+    if (nleaf>gen_stats.leaves) gen_stats.leaves = nleaf;
+    i = random_below(nleaf);
+    p = leaf[i];
+    leaf[i] = leaf[--nleaf];
+    board[p] = WALL;
+    SET(wall,p);
+    if (tree[p]&LEFT) { q = p-1; tree[q] &= ~RIGHT; }
+    else if (tree[p]&RIGHT) { q = p+1; tree[q] &= ~LEFT; }
+    else if (tree[p]&UP) { q = p-stride; tree[q] &= ~DOWN; }
+    else { q = p+stride; tree[q] &= ~UP; }
+    tree[p] = 0;
+    if (q!=start && degree(q)==1) leaf[nleaf++] = q;
+  }
+
+  /* player where the tree is rooted, items on random cells of it */
+  player.x = start%stride-1;
+  player.y = start/stride-1;
+  player.dx = player.dy = 0;
+  board[start] = PLAYER;
+  for (y=0;y<height;y++) {
+    for (x=0;x<width;x++) {
+      if (board[AT(x,y)]==EMPTY) region[nregion++] = AT(x,y);
+    }
+  }
+  for (i=0;i<ITEMS;i++) {
+    for (j=0;j<item[i].num;j++) {
+      p = random_below(nregion);
+      board[region[p]] = (unsigned char)(ITEM0+i);
+      region[p] = region[--nregion];
+    }
+  }
+
+  gen_stats.boards++;
+  if (count_reachable()!=cur_items) {
+    fprintf(stderr,"hectic: unreachable items on a constructed board\n");
+    abort();
+  }
+  return true;
+}
+
+/************************************************************************
+ * the items of a level, more on a larger board
+ */
+
+void init_items() {
+  item[0].val = 10; item[0].ch = "<>"; item[0].num = 10*scale;
+  item[1].val = 20; item[1].ch = "::"; item[1].num = 5*scale;
+  item[2].val = 50; item[2].ch = "$$"; item[2].num = 1*scale;
+}
+
+/************************************************************************
+ * the blocks of a level number
+ */
+
+int level_blocks(int level) {
+  return (20+8*(level-1))*scale;
+}
+
+/************************************************************************
+ * one step of the player in its direction. Running into a wall, also
+ * the edge of the board, costs one energy and the player stays where
+ * it is. An item is collected on the way, its value is added to *gold.
+ * Returns the energy lost.
+ */
+
+int move_player(int *gold) {
+  int p = AT(player.x+player.dx,player.y+player.dy);
+
+  if (board[p] == WALL) return 1;
+  if (board[p] >= ITEM0) {
+    *gold += item[board[p]-ITEM0].val;
+    cur_items--;
+  }
+  board[AT(player.x,player.y)] = EMPTY;
+  player.x += player.dx;
+  player.y += player.dy;
+  board[p] = PLAYER;
+  return 0;
+}
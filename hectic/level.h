@@ -0,0 +1,90 @@
+
+/*********************************************************************
+ *
+ * level.h - the board of hectic, its generator and its rules
+ *
+ * Shared by the game and by hecticplan, so no curses in here.
+ */
+
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* constants for elements on the board */
+enum itemtype_t {
+  EMPTY,
+  WALL,
+  PLAYER,
+  ITEM0};
+
+/* the board, one byte per cell, row by row. A ring of walls goes
+   around it, so board[AT(x,y)] is a cell for x in -1..width and y in
+   -1..height, and a step never leaves the array. */
+#define MAX_SIZE 2000
+extern int width, height;		/* 37x19 unless changed */
+extern int stride;			/* width+2 */
+extern int cells;			/* width*height, without the ring */
+extern int scale;			/* cells per 37x19, at least 1 */
+extern unsigned char *board;
+#define AT(x,y)	(((y)+1)*stride+(x)+1)
+
+/* bitsets over the cells of board[] */
+#define TEST(s,p)	((s)[(p)>>6]>>((p)&63)&1)
+#define SET(s,p)	((s)[(p)>>6] |= (uint64_t)1<<((p)&63))
+#define CLEAR(s,p)	((s)[(p)>>6] &= ~((uint64_t)1<<((p)&63)))
+extern uint64_t *wall;			/* walls, set by place_items() */
+extern uint64_t *seen;			/* scratch, for searches */
+extern size_t words;			/* of a bitset */
+
+extern struct player_t {
+  int x,y;			/* player position */
+  int dx,dy;			/* player speed */
+} player;
+
+/* the items */
+struct item_t {
+  int val;			/* score for this type of item */
+  char *ch;			/* char to display this item */
+  int num;			/* number of items of this type */
+};
+
+#define ITEMS	3
+extern struct item_t item[ITEMS];
+extern int cur_items;			/* number of items on the board */
+
+/* set stride, cells and scale for width x height */
+void size_board(void);
+
+/* what the generator did, added up until reset, for hecticbench */
+extern struct gen_stats_t {
+  long boards;			/* generated */
+  long visited;			/* cells visited by count_reachable() */
+  long depth;			/* largest stack of count_reachable() */
+  long leaves;			/* most leaves place_items() could pick from */
+} gen_stats;
+
+/* allocate a board of width x height, false if out of memory */
+bool alloc_board(void);
+
+/* set the items according to the size of the board */
+void init_items(void);
+
+/* the blocks of a level number, 20 and 8 more with every level */
+int level_blocks(int level);
+
+/* a new level with that many blocks, false if they don't fit */
+bool place_items(int blocks);
+
+/* the number of items the player can reach */
+int count_reachable(void);
+
+/* one step of the player, returns the energy lost */
+int move_player(int *gold);
+
+/* random number in 0..n-1, also for n beyond RAND_MAX */
+int random_below(int n);
+
+#endif
@@ -0,0 +1,154 @@
+
+/*********************************************************************
+ *
+ * pack.c - a pack of pregenerated hectic levels, see pack.h
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "level.h"
+#include "pack.h"
+
+/* the items and the walls after the fixed part of a record */
+#define COORDS(r)	((uint16_t *)((r)+1))
+#define WALLS(r)	((uint8_t *)(COORDS(r)+2*(r)->items))
+
+static int items_of_board() {
+  int i, n = 0;
+  for (i=0;i<ITEMS;i++) n += item[i].num;
+  return n;
+}
+
+size_t pack_record_size() {
+  size_t n = sizeof(struct pack_record_t)
+    + 2*sizeof(uint16_t)*(size_t)items_of_board() + ((size_t)cells+7)/8;
+  return (n+3)&~(size_t)3;
+}
+
+const struct pack_record_t *pack_record(const struct pack_header_t *h,
+					int level, int variant) {
+  return (const struct pack_record_t *)((const char *)(h+1)
+	 + ((size_t)(level-1)*h->variants+(size_t)variant)*h->record_size);
+}
+
+void pack_store(struct pack_record_t *r, int blocks, double seconds) {
+  uint16_t *c;
+  uint8_t *w;
+  int i, x, y, n;
+
+  r->usec = (uint32_t)(seconds*1e6);
+  r->blocks = (uint32_t)blocks;
+  r->items = (uint32_t)items_of_board();
+  r->x = (uint16_t)player.x;
+  r->y = (uint16_t)player.y;
+
+  c = COORDS(r);
+  for (i=0;i<ITEMS;i++) {
+    for (y=0;y<height;y++) {
+      for (x=0;x<width;x++) {
+	if (board[AT(x,y)] == ITEM0+i) {
+	  *c++ = (uint16_t)x;
+	  *c++ = (uint16_t)y;
+	}
+      }
+    }
+  }
+
+  w = WALLS(r);
+  memset(w,0,((size_t)cells+7)/8);
+  for (n=0;n<cells;n++) {
+    if (board[AT(n%width,n/width)] == WALL) w[n/8] |= (uint8_t)(1<<n%8);
+  }
+}
+
+bool pack_load(const struct pack_record_t *r) {
+  const uint16_t *c;
+  const uint8_t *w;
+  int i, j, n, p;
+
+  if ((int)r->items != items_of_board() || r->x >= width || r->y >= height)
+    return false;
+
+  /* walls, the ring stays */
+  memset(board,WALL,(size_t)stride*(height+2));
+  memset(wall,0xff,words*sizeof(uint64_t));
+  w = WALLS(r);
+  for (n=0;n<cells;n++) {
+    if (!(w[n/8]>>n%8&1)) {
+      p = AT(n%width,n/width);
+      board[p] = EMPTY;
+      CLEAR(wall,p);
+    }
+  }
+
+  player.x = r->x;
+  player.y = r->y;
+  player.dx = player.dy = 0;
+  if (board[AT(player.x,player.y)] != EMPTY) return false;
+  board[AT(player.x,player.y)] = PLAYER;
+
+  c = COORDS(r);
+  for (i=0;i<ITEMS;i++) {
+    for (j=0;j<item[i].num;j++,c+=2) {
+      if (c[0] >= width || c[1] >= height || board[AT(c[0],c[1])] != EMPTY)
+	return false;
+      board[AT(c[0],c[1])] = (unsigned char)(ITEM0+i);
+    }
+  }
+  cur_items = (int)r->items;
+  return count_reachable() == cur_items;
+}
+
+const struct pack_header_t *pack_open(const char *path, const char **error) {
+  const struct pack_header_t *h;
+  struct stat st;
+  void *map;
+  int fd;
+
+  if ((fd = open(path,O_RDONLY)) < 0 || fstat(fd,&st) < 0) {
+    *error = "cannot open it";
+    if (fd >= 0) close(fd);
+    return NULL;
+  }
+  if ((size_t)st.st_size < sizeof(*h)) {
+    *error = "not a level pack";
+    close(fd);
+    return NULL;
+  }
+  map = mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    *error = "cannot map it";
+    return NULL;
+  }
+
+  h = map;
+  *error = NULL;
+  if (memcmp(h->magic,PACK_MAGIC,sizeof(h->magic)) != 0)
+    *error = "not a level pack";
+  else if (h->version != PACK_VERSION)
+    *error = "unknown version";
+  else if (h->byte_order != 0x01020304)
+    *error = "written in another byte order";
+  else if (h->width < 1 || h->width > MAX_SIZE || h->height < 1 || h->height > MAX_SIZE)
+    *error = "bad board size";
+  else {
+    width = h->width;
+    height = h->height;
+    size_board();
+    init_items();
+    if (h->record_size != pack_record_size() || h->variants < 1
+	|| (size_t)st.st_size < sizeof(*h)+(size_t)h->levels*h->variants*h->record_size)
+      *error = "truncated or bad records";
+  }
+  if (*error != NULL) {
+    munmap(map,(size_t)st.st_size);
+    return NULL;
+  }
+  return h;
+}
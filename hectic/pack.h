@@ -0,0 +1,65 @@
+
+/*********************************************************************
+ *
+ * pack.h - a pack of pregenerated hectic levels
+ *
+ * A pack is a header followed by records of fixed size, 'variants'
+ * records for every level number from 1 to 'levels', so a level is
+ * found by its offset and the game can map the file and take any level
+ * at once. Numbers are in the byte order of the machine that wrote the
+ * pack, the header tells which one that was.
+ *
+ * A record holds the player, the items and the walls of a board of
+ * width x height, one bit per cell row by row, lowest bit first. The
+ * items are sorted by their type in item[], with as many of each type
+ * as init_items() gives for that board.
+ */
+
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PACK_MAGIC	"HECTPAK"
+#define PACK_VERSION	1
+
+struct pack_header_t {
+  char magic[8];		/* PACK_MAGIC */
+  uint32_t version;		/* PACK_VERSION */
+  uint32_t byte_order;		/* 0x01020304 as written */
+  uint32_t record_size;		/* pack_record_size() */
+  uint16_t width, height;	/* of the board */
+  uint32_t levels;		/* level numbers 1..levels */
+  uint32_t variants;		/* records per level number */
+  uint32_t seed;		/* of hecticpack */
+  uint8_t reserved[28];
+};
+
+struct pack_record_t {
+  uint32_t usec;		/* it took to generate the level */
+  uint32_t blocks;
+  uint32_t items;
+  uint16_t x, y;		/* of the player */
+  /* followed by x and y of every item as uint16_t, then the walls */
+};
+
+/* size of a record for the current board size, a multiple of 4 */
+size_t pack_record_size(void);
+
+/* the record of a level number and variant */
+const struct pack_record_t *pack_record(const struct pack_header_t *h,
+					int level, int variant);
+
+/* store the current board in r */
+void pack_store(struct pack_record_t *r, int blocks, double seconds);
+
+/* load r onto the board, false if it isn't a valid level */
+bool pack_load(const struct pack_record_t *r);
+
+/* map a pack, checks the header and sets width and height. Returns
+   the header, or NULL with the reason in *error. */
+const struct pack_header_t *pack_open(const char *path, const char **error);
+
+#endif
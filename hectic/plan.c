@@ -0,0 +1,207 @@
+
+/*********************************************************************
+ *
+ * plan.c - the autopilot of hectic, see plan.h
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "level.h"
+#include "plan.h"
+
+#define NEAREST	-1		/* search for the nearest item not taken */
+#define ALL	-2		/* search all reachable cells */
+
+static int *dist;		/* steps from the start of a search, -1 if not reached */
+static int *queue;		/* cells reached by the last search */
+static int nqueue;
+static int room;		/* size of plan->key */
+static int left;		/* items not taken yet */
+
+/************************************************************************
+ * breadth first search from cell 'from' until cell 'to', or the nearest
+ * item that is not taken yet (in seen[]), or all reachable cells.
+ * Returns the cell found, or -1.
+ */
+
+static int search(int from, int to) {
+  int dir[4];
+  int head = 0, p, q, i;
+
+  dir[0] = -1; dir[1] = 1; dir[2] = -stride; dir[3] = stride;
+  for (i=0;i<nqueue;i++) dist[queue[i]] = -1;	/* forget the last one */
+  nqueue = 0;
+  dist[from] = 0;
+  queue[nqueue++] = from;
+  while (head<nqueue) {
+    p = queue[head++];
+    if (p==to || (to==NEAREST && board[p]>=ITEM0 && !TEST(seen,p))) return p;
+    for (i=0;i<4;i++) {
+      q = p+dir[i];
+      if (!TEST(wall,q) && dist[q]<0) {
+	dist[q] = dist[p]+1;
+	queue[nqueue++] = q;
+      }
+    }
+  }
+  return -1;
+}
+
+/************************************************************************
+ * append the way to cell 'to' of the last search to the plan, and take
+ * the items on it
+ */
+
+static bool append(struct plan_t *plan, int to) {
+  int dir[4];
+  char key[4];
+  int p, q, i, k;
+  char *more;
+
+  if (plan->steps+dist[to]>room) {
+    room = 2*room+dist[to];
+    if ((more = realloc(plan->key,(size_t)room)) == NULL) return false;
+    plan->key = more;
+  }
+
+  /* backwards from the end, over cells ever closer to the start */
+  dir[0] = -1; dir[1] = 1; dir[2] = -stride; dir[3] = stride;
+  key[0] = 'l'; key[1] = 'h'; key[2] = 'j'; key[3] = 'k';
+  p = to;
+  for (k=dist[to]-1;k>=0;k--) {
+    if (board[p]>=ITEM0 && !TEST(seen,p)) {
+      SET(seen,p);
+      left--;
+    }
+    for (i=0;i<4;i++) {
+      q = p+dir[i];
+      if (dist[q]==k) break;
+    }
+    plan->key[plan->steps+k] = key[i];
+    p = q;
+  }
+  plan->steps += dist[to];
+  return true;
+}
+
+/************************************************************************
+ * the order of the items on the shortest walk: Held-Karp over subsets,
+ * dp[mask*m+j] is the shortest walk from the start over the items in
+ * mask that ends at item j. d is the distance matrix of the start (0)
+ * and the m items (1..m).
+ */
+
+static bool shortest_order(int m, const int *d, int *order) {
+  int full = (1<<m)-1;
+  int *dp;
+  int mask, prev, i, j, t, v;
+
+  if ((dp = malloc((size_t)(full+1)*(size_t)m*sizeof(int))) == NULL) return false;
+  for (i=0;i<(full+1)*m;i++) dp[i] = INT_MAX;
+  for (j=0;j<m;j++) dp[(1<<j)*m+j] = d[j+1];
+
+  for (mask=1;mask<=full;mask++) {
+    for (j=0;j<m;j++) {
+      if (!(mask>>j&1) || dp[mask*m+j]==INT_MAX) continue;
+      for (i=0;i<m;i++) {
+	if (mask>>i&1) continue;
+	v = dp[mask*m+j]+d[(j+1)*(m+1)+i+1];
+	if (v<dp[(mask|1<<i)*m+i]) dp[(mask|1<<i)*m+i] = v;
+      }
+    }
+  }
+
+  j = 0;
+  for (i=1;i<m;i++) {
+    if (dp[full*m+i]<dp[full*m+j]) j = i;
+  }
+  mask = full;
+  order[m-1] = j;
+  for (t=m-1;t>0;t--) {
+    prev = mask & ~(1<<j);
+    for (i=0;i<m;i++) {
+      if ((prev>>i&1) && dp[prev*m+i]!=INT_MAX
+	  && dp[prev*m+i]+d[(i+1)*(m+1)+j+1]==dp[mask*m+j]) break;
+    }
+    order[t-1] = i;
+    mask = prev;
+    j = i;
+  }
+  free(dp);
+  return true;
+}
+
+/************************************************************************
+ * plan the current board
+ */
+
+bool make_plan(struct plan_t *plan) {
+  int n = stride*(height+2);
+  int *target = NULL, *d = NULL, *order = NULL;
+  int k = 0, p, i, j;
+  bool ok = false;
+
+  plan->key = NULL;
+  plan->steps = plan->turns = 0;
+  plan->exact = cur_items<=PLAN_EXACT;
+  room = 0;
+  left = cur_items;
+  nqueue = 0;
+
+  dist = malloc((size_t)n*sizeof(int));
+  queue = malloc((size_t)n*sizeof(int));
+  target = malloc((size_t)(cur_items+1)*sizeof(int));
+  if (dist==NULL || queue==NULL || target==NULL) goto out;
+  for (p=0;p<n;p++) dist[p] = -1;
+  memset(seen,0,words*sizeof(uint64_t));
+
+  target[k++] = AT(player.x,player.y);
+  for (p=0;p<n && k<=cur_items;p++) {
+    if (board[p]>=ITEM0) target[k++] = p;
+  }
+
+  if (plan->exact) {
+    /* the distances between start and items, then the best order */
+    d = malloc((size_t)k*(size_t)k*sizeof(int));
+    order = malloc((size_t)k*sizeof(int));
+    if (d==NULL || order==NULL) goto out;
+    for (i=0;i<k;i++) {
+      search(target[i],ALL);
+      for (j=0;j<k;j++) {
+	if ((d[i*k+j] = dist[target[j]])<0) goto out;
+      }
+    }
+    if (k>1 && !shortest_order(k-1,d,order)) goto out;
+    for (i=0;i<k-1;i++) {
+      if (search(i>0 ? target[order[i-1]+1] : target[0],target[order[i]+1])<0
+	  || !append(plan,target[order[i]+1])) goto out;
+    }
+  } else {
+    /* always to the nearest item */
+    p = target[0];
+    while (left>0) {
+      if ((p = search(p,NEAREST))<0 || !append(plan,p)) goto out;
+    }
+  }
+
+  for (i=0;i<plan->steps;i++) {
+    if (i==0 || plan->key[i]!=plan->key[i-1]) plan->turns++;
+  }
+  ok = true;
+
+ out:
+  free(dist);
+  free(queue);
+  free(target);
+  free(d);
+  free(order);
+  if (!ok) free_plan(plan);
+  return ok;
+}
+
+void free_plan(struct plan_t *plan) {
+  free(plan->key);
+  plan->key = NULL;
+  plan->steps = plan->turns = 0;
+}
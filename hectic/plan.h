@@ -0,0 +1,34 @@
+
+/*********************************************************************
+ *
+ * plan.h - the autopilot of hectic
+ *
+ * A plan is a key for every step that collects all items of the board
+ * from where the player is. The player may turn at any step, also
+ * around, so it never has to run into a wall: a plan loses no energy,
+ * and the shortest plan is the shortest walk over all items. That is
+ * found exactly (Held-Karp over the distances between the items) for
+ * up to PLAN_EXACT items, otherwise the nearest item is taken next.
+ */
+
+#ifndef PLAN_H
+#define PLAN_H
+
+#include <stdbool.h>
+
+#define PLAN_EXACT	16
+
+struct plan_t {
+  char *key;			/* 'h', 'j', 'k' or 'l' for every step */
+  int steps;
+  int turns;			/* changes of direction, the first counts */
+  bool exact;			/* shortest possible */
+};
+
+/* plan the current board, false if out of memory or an item is
+   unreachable */
+bool make_plan(struct plan_t *plan);
+
+void free_plan(struct plan_t *plan);
+
+#endif
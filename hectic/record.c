@@ -0,0 +1,87 @@
+
+/*********************************************************************
+ *
+ * record.c - recordings of hectic games, see record.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "record.h"
+
+static unsigned char *events;	/* recorded or read */
+static size_t size, room, pos;	/* bytes used, allocated, read */
+static long last;		/* tick of the last event */
+
+bool record_event(long tick, int key) {
+  unsigned long n = (unsigned long)(tick-last)*8+(unsigned long)key;
+  unsigned char *more;
+
+  if (size+10 > room) {
+    room = 2*room+64;
+    if ((more = realloc(events,room)) == NULL) return false;
+    events = more;
+  }
+  while (n >= 128) {
+    events[size++] = (unsigned char)(n|128);
+    n >>= 7;
+  }
+  events[size++] = (unsigned char)n;
+  last = tick;
+  return true;
+}
+
+bool record_write(const char *path, struct record_header_t *h) {
+  FILE *f;
+  bool ok;
+
+  memcpy(h->magic,RECORD_MAGIC,sizeof(h->magic));
+  h->version = RECORD_VERSION;
+  h->byte_order = 0x01020304;
+  h->size = (uint32_t)size;
+  if ((f = fopen(path,"wb")) == NULL) return false;
+  ok = fwrite(h,sizeof(*h),1,f) == 1 && (size == 0 || fwrite(events,size,1,f) == 1);
+  return fclose(f) == 0 && ok;
+}
+
+const struct record_header_t *record_read(const char *path, const char **error) {
+  static struct record_header_t h;
+  FILE *f;
+
+  if ((f = fopen(path,"rb")) == NULL) {
+    *error = "cannot open it";
+    return NULL;
+  }
+  *error = NULL;
+  if (fread(&h,sizeof(h),1,f) != 1 || memcmp(h.magic,RECORD_MAGIC,sizeof(h.magic)) != 0)
+    *error = "not a recording";
+  else if (h.version != RECORD_VERSION)
+    *error = "unknown version";
+  else if (h.byte_order != 0x01020304)
+    *error = "written in another byte order";
+  else if ((events = malloc(h.size+1)) == NULL)
+    *error = "out of memory";
+  else if (h.size > 0 && fread(events,h.size,1,f) != 1)
+    *error = "truncated";
+  fclose(f);
+  if (*error != NULL) return NULL;
+  size = h.size;
+  pos = 0;
+  last = 0;
+  return &h;
+}
+
+bool record_next(long *tick, int *key) {
+  unsigned long n = 0;
+  int shift = 0;
+
+  do {
+    if (pos >= size || shift > 28) return false;
+    n |= (unsigned long)(events[pos]&127)<<shift;
+    shift += 7;
+  } while (events[pos++]&128);
+  last += (long)(n/8);
+  *tick = last;
+  *key = (int)(n%8);
+  return true;
+}
@@ -0,0 +1,57 @@
+
+/*********************************************************************
+ *
+ * record.h - recordings of hectic games
+ *
+ * A game only depends on its seed, the options it was started with and
+ * the keys that changed the player in every tick, so that is all a
+ * recording holds, together with the final results to check a replay
+ * against. A key that arrives between step n and n+1 belongs to tick n.
+ *
+ * The header is followed by the events, each one a number in 7 bit
+ * groups, lowest first with the high bit set on all but the last, of
+ * (ticks since the last event)*8+key.
+ */
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RECORD_MAGIC	"HECTREC"
+#define RECORD_VERSION	2
+
+/* the keys */
+enum { REC_LEFT, REC_RIGHT, REC_UP, REC_DOWN, REC_QUIT };
+
+struct record_header_t {
+  char magic[8];		/* RECORD_MAGIC */
+  uint32_t version;		/* RECORD_VERSION */
+  uint32_t byte_order;		/* 0x01020304 as written */
+  uint32_t seed;		/* of srand() */
+  uint16_t width, height;	/* of the board */
+  uint32_t tick_us;		/* of level 1 */
+  uint32_t speedup;		/* -s */
+  uint32_t pack_seed;		/* of the pack played, if any */
+  uint32_t packed;		/* 1 if it was played from a pack */
+  int32_t score, level, blocks;	/* at the end */
+  uint32_t ticks;		/* of the whole game */
+  uint32_t size;		/* bytes of events */
+  uint32_t hazards;		/* -m, since version 2 */
+};
+
+/* add an event to the recording */
+bool record_event(long tick, int key);
+
+/* write the header and the events */
+bool record_write(const char *path, struct record_header_t *h);
+
+/* read a recording, returns its header, or NULL with the reason in
+   *error */
+const struct record_header_t *record_read(const char *path, const char **error);
+
+/* the next event of the recording read, false at its end */
+bool record_next(long *tick, int *key);
+
+#endif
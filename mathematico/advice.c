@@ -0,0 +1,162 @@
+
+/*********************************************************************
+ *
+ * advice.c - rank the empty cells for the current card
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "advice.h"
+#include "policy.h"
+
+#define MAX_WORKERS	16
+#define BATCH		32	/* rollouts between two looks at the totals */
+
+static struct game_t start;	/* the game to advise on */
+static int ncells;
+static int cell_x[COLS*ROWS], cell_y[COLS*ROWS];
+
+/* totals of all workers, guarded by lock */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static long n[COLS*ROWS];
+static double sum[COLS*ROWS], sum2[COLS*ROWS];
+static long rollouts;
+static bool stop;
+
+static double started, deadline, finished;
+static pthread_t worker[MAX_WORKERS];
+static int nworkers;
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static uint64_t mix(uint64_t z) {
+  z = (z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+  z = (z^(z>>27))*0x94D049BB133111EBULL;
+  return z^(z>>31);
+}
+
+static void *work(void *arg) {
+  long id = (long)arg;
+  long bn[COLS*ROWS];
+  double bsum[COLS*ROWS], bsum2[COLS*ROWS];
+  uint64_t seed = mix(start.rng^mix((uint64_t)id));
+  bool done = false;
+
+  while (!done) {
+    for (int i=0;i<ncells;i++) bn[i] = bsum[i] = bsum2[i] = 0;
+
+    /* every cell gets the same number of rollouts */
+    for (int b=0;b<BATCH;b++) {
+      for (int i=0;i<ncells;i++) {
+	struct game_t g = start;
+	g.rng = mix(++seed);
+	game_place(&g,cell_x[i],cell_y[i],g.card);
+	play_out(&g,rate_gain);
+	double t = game_total(&g);
+	bn[i]++;
+	bsum[i] += t;
+	bsum2[i] += t*t;
+      }
+    }
+
+    pthread_mutex_lock(&lock);
+    for (int i=0;i<ncells;i++) {
+      n[i] += bn[i];
+      sum[i] += bsum[i];
+      sum2[i] += bsum2[i];
+      rollouts += bn[i];
+    }
+    if (now()>=deadline) stop = true;
+    done = stop;
+    if (done) finished = now();
+    pthread_mutex_unlock(&lock);
+  }
+  return NULL;
+}
+
+void advice_start(const struct game_t *g, double seconds) {
+  advice_stop();
+
+  start = *g;
+  ncells = 0;
+  for (int x=0;x<COLS;x++) {
+    for (int y=0;y<ROWS;y++) {
+      if (g->board[x][y]==0) {
+	cell_x[ncells] = x;
+	cell_y[ncells] = y;
+	n[ncells] = 0;
+	sum[ncells] = sum2[ncells] = 0;
+	ncells++;
+      }
+    }
+  }
+  if (ncells==0 || g->card==0) return;
+
+  rollouts = 0;
+  stop = false;
+  started = now();
+  deadline = started+seconds;
+  finished = 0;
+
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cpus<1) cpus = 1;
+  if (cpus>MAX_WORKERS) cpus = MAX_WORKERS;
+  for (nworkers=0;nworkers<cpus;nworkers++)
+    if (pthread_create(&worker[nworkers],NULL,work,(void *)(long)nworkers)!=0)
+      break;
+}
+
+void advice_stop() {
+  pthread_mutex_lock(&lock);
+  stop = true;
+  pthread_mutex_unlock(&lock);
+  while (nworkers>0)
+    pthread_join(worker[--nworkers],NULL);
+}
+
+bool advice_running() {
+  pthread_mutex_lock(&lock);
+  bool running = nworkers>0 && !stop;
+  pthread_mutex_unlock(&lock);
+  return running;
+}
+
+int advice_ranking(struct advice_t *cells, int max, double *rollouts_per_second) {
+  struct advice_t all[COLS*ROWS];
+
+  pthread_mutex_lock(&lock);
+  for (int i=0;i<ncells;i++) {
+    all[i].x = cell_x[i];
+    all[i].y = cell_y[i];
+    all[i].n = n[i];
+    all[i].mean = n[i]>0 ? sum[i]/n[i] : 0;
+    double var = n[i]>1 ? (sum2[i]-sum[i]*sum[i]/n[i])/(n[i]-1) : 0;
+    all[i].ci = n[i]>1 ? 1.96*sqrt(var>0 ? var : 0)/sqrt((double)n[i]) : 0;
+  }
+  double elapsed = (finished>0 ? finished : now())-started;
+  *rollouts_per_second = elapsed>0 ? rollouts/elapsed : 0;
+  pthread_mutex_unlock(&lock);
+
+  /* best first */
+  for (int i=1;i<ncells;i++) {
+    struct advice_t a = all[i];
+    int j = i;
+    while (j>0 && all[j-1].mean<a.mean) {
+      all[j] = all[j-1];
+      j--;
+    }
+    all[j] = a;
+  }
+
+  int k = ncells<max ? ncells : max;
+  for (int i=0;i<k;i++) cells[i] = all[i];
+  return k;
+}
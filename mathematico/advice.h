@@ -0,0 +1,36 @@
+
+/*********************************************************************
+ *
+ * advice.h - rank the empty cells for the current card
+ *
+ * Worker threads play the rest of the game greedily from every empty
+ * cell, over and over, until the time budget is used up or the advice
+ * is stopped. The ranking can be read at any time and gets better the
+ * longer the search runs.
+ */
+
+#ifndef ADVICE_H
+#define ADVICE_H
+
+#include "engine.h"
+
+struct advice_t {
+  int x, y;
+  long n;			/* rollouts */
+  double mean;			/* expected final score */
+  double ci;			/* half width of the 95% confidence interval */
+};
+
+/* start ranking the empty cells for g->card */
+void advice_start(const struct game_t *g, double seconds);
+
+/* stop the workers and wait for them */
+void advice_stop();
+
+/* true, while the workers are running */
+bool advice_running();
+
+/* up to max cells, best first, returns their number */
+int advice_ranking(struct advice_t *cells, int max, double *rollouts_per_second);
+
+#endif
@@ -0,0 +1,110 @@
+
+/*********************************************************************
+ *
+ * engine.c - the rules of mathematico, without any user interface
+ */
+
+#include "engine.h"
+
+void game_init(struct game_t *g, uint64_t seed) {
+  for (int x=0;x<COLS;x++) {
+    for (int y=0;y<ROWS;y++) {
+      g->board[x][y] = 0;
+    }
+  }
+  for (int i=0;i<LINES;i++) {
+    g->score[i] = 0;
+    g->hist[i] = 0;
+  }
+  for (int i=0;i<=CARDS;i++) g->drawn_cards[i] = 0;
+  g->total = 0;
+  g->filled = 0;
+  g->card = 0;
+  g->seed = seed;
+  g->rng = seed;
+}
+
+/* splitmix64, good enough for cards and cheap to seed */
+static uint64_t next_random(struct game_t *g) {
+  uint64_t z = (g->rng += 0x9E3779B97F4A7C15ULL);
+  z = (z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+  z = (z^(z>>27))*0x94D049BB133111EBULL;
+  return z^(z>>31);
+}
+
+uint32_t game_random(struct game_t *g, uint32_t n) {
+  return (uint32_t)(((next_random(g)>>32)*n)>>32);
+}
+
+int game_deal(struct game_t *g) {
+  int c;
+  do {
+    c = (int)game_random(g,CARDS)+1;
+  } while (g->drawn_cards[c]>=COPIES);
+  g->drawn_cards[c]++;
+  g->card = c;
+  return c;
+}
+
+/* lines through (x,y), returns their number */
+static inline int lines_of(int x, int y, int lines[4]) {
+  int n = 0;
+  lines[n++] = x;
+  lines[n++] = COLS+y;
+  if (x==y) lines[n++] = COLS+ROWS;
+  if (x==COLS-1-y) lines[n++] = COLS+ROWS+1;
+  return n;
+}
+
+/* add d to the histograms of the lines through (x,y) and score them */
+static void rescore(struct game_t *g, int x, int y, uint64_t d) {
+  int lines[4];
+  int n = lines_of(x,y,lines);
+
+  for (int i=0;i<n;i++) {
+    int l = lines[i];
+    g->hist[l] += d;
+    int s = score_of_hist(l,g->hist[l]);
+    g->total += s-g->score[l];
+    g->score[l] = s;
+  }
+}
+
+void game_place(struct game_t *g, int x, int y, int c) {
+  g->board[x][y] = c;
+  g->order[g->filled++] = (uint8_t)(x*ROWS+y);
+  rescore(g,x,y,score_bit[c]);
+}
+
+void game_unplace(struct game_t *g, int x, int y) {
+  int c = g->board[x][y];
+  g->board[x][y] = 0;
+  g->filled--;
+  rescore(g,x,y,-score_bit[c]);
+}
+
+int game_gain(const struct game_t *g, int x, int y, int c) {
+  int lines[4];
+  int n = lines_of(x,y,lines);
+  int gain = 0;
+
+  for (int i=0;i<n;i++) {
+    int l = lines[i];
+    gain += score_of_hist(l,g->hist[l]+score_bit[c])-g->score[l];
+  }
+  return gain;
+}
+
+void game_rescan(struct game_t *g) {
+  g->total = score_board((const int (*)[ROWS])g->board,g->score);
+  g->filled = 0;
+  for (int i=0;i<LINES;i++) g->hist[i] = 0;
+  for (int x=0;x<COLS;x++) {
+    for (int y=0;y<ROWS;y++) {
+      int lines[4];
+      int n = lines_of(x,y,lines);
+      for (int i=0;i<n;i++) g->hist[lines[i]] += score_bit[g->board[x][y]];
+      if (g->board[x][y]!=0) g->order[g->filled++] = (uint8_t)(x*ROWS+y);
+    }
+  }
+}
@@ -0,0 +1,64 @@
+
+/*********************************************************************
+ *
+ * engine.h - the rules of mathematico, without any user interface
+ *
+ * All state of a game lives in a struct game_t, so any number of games
+ * can be played side by side, also in different threads. Every game
+ * has its own random generator; a game is reproducible from its seed.
+ */
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "score.h"
+
+#define CARDS	13		/* card values 1..13 */
+#define COPIES	((2*COLS*ROWS+CARDS-1)/CARDS)	/* of each value, 4 on 5x5 */
+
+struct game_t {
+  int board[COLS][ROWS];	/* 0 for an empty cell */
+  int score[LINES];
+  uint64_t hist[LINES];		/* rank histogram of each line, see score.h */
+  int total;			/* sum of score[] */
+  int filled;			/* number of cards on the board */
+  int card;			/* current card, 0 before the first deal */
+  int drawn_cards[CARDS+1];	/* number of drawn cards per value */
+  uint8_t order[COLS*ROWS];	/* cell x*ROWS+y of every card in order of placing */
+  uint64_t seed;		/* of game_init() */
+  uint64_t rng;			/* state of the random generator */
+};
+
+/* start a new game */
+void game_init(struct game_t *g, uint64_t seed);
+
+/* draw the next card from the deck, returns it */
+int game_deal(struct game_t *g);
+
+/* put card c on the empty cell (x,y) and score the lines through it */
+void game_place(struct game_t *g, int x, int y, int c);
+
+/* take back the card on (x,y), the last one placed */
+void game_unplace(struct game_t *g, int x, int y);
+
+/* change of the total, if card c went on the empty cell (x,y) */
+int game_gain(const struct game_t *g, int x, int y, int c);
+
+/* score the whole board again, the same as game_place() keeps up to date */
+void game_rescan(struct game_t *g);
+
+static inline int game_total(const struct game_t *g) {
+  return g->total;
+}
+
+/* true, if end of game */
+static inline bool game_finished(const struct game_t *g) {
+  return g->filled==ROWS*COLS;
+}
+
+/* random number in 0..n-1 from the generator of the game */
+uint32_t game_random(struct game_t *g, uint32_t n);
+
+#endif
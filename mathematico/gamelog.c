@@ -0,0 +1,99 @@
+
+/*********************************************************************
+ *
+ * gamelog.c - append-only binary log of mathematico games
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "gamelog.h"
+
+/* a record of a 5x5 game must stay one 64 byte block */
+#if COLS==5 && ROWS==5
+typedef char log_record_size[sizeof(struct log_record_t)==64 ? 1 : -1];
+#endif
+typedef char log_header_size[sizeof(struct log_header_t)==64 ? 1 : -1];
+
+const char *const log_source[LOG_SOURCES] = {
+  "ui", "random", "greedy", "heuristic"
+};
+
+static void make_header(struct log_header_t *h) {
+  memset(h,0,sizeof(*h));
+  memcpy(h->magic,LOG_MAGIC,sizeof(LOG_MAGIC));
+  h->version = LOG_VERSION;
+  h->byte_order = 0x01020304;
+  h->record_size = sizeof(struct log_record_t);
+  h->cols = COLS;
+  h->rows = ROWS;
+}
+
+void log_fill(struct log_record_t *r, const struct game_t *g, int source) {
+  memset(r,0,sizeof(*r));
+  r->seed = g->seed;
+  for (int i=0;i<g->filled;i++) {
+    int c = g->order[i];
+    r->cell[i] = (uint8_t)c;
+    r->card[i/2] |= (uint8_t)(g->board[c/ROWS][c%ROWS]<<(i&1 ? 4 : 0));
+  }
+  for (int l=0;l<LINES;l++) r->score[l] = (uint8_t)g->score[l];
+  r->total = (uint16_t)g->total;
+  r->moves = (uint8_t)g->filled;
+  r->source = (uint8_t)source;
+}
+
+int log_open(const char *path) {
+  struct log_header_t want, have;
+  int fd = open(path,O_RDWR|O_CREAT|O_APPEND,0666);
+  if (fd<0) return -1;
+
+  make_header(&want);
+  ssize_t n = pread(fd,&have,sizeof(have),0);
+  if (n==0) {
+    if (write(fd,&want,sizeof(want))==sizeof(want)) return fd;
+  } else if (n==sizeof(have) && memcmp(&have,&want,sizeof(want))==0) {
+    return fd;
+  } else if (n>=0) {
+    errno = EINVAL;		/* not a log of this build */
+  }
+  int e = errno;
+  close(fd);
+  errno = e;
+  return -1;
+}
+
+int log_write(int fd, const struct log_record_t *r, int n) {
+  const char *p = (const char *)r;
+  size_t left = (size_t)n*sizeof(*r);
+
+  while (left>0) {
+    ssize_t w = write(fd,p,left);
+    if (w<0) {
+      if (errno==EINTR) continue;
+      return -1;
+    }
+    p += w;
+    left -= (size_t)w;
+  }
+  return 0;
+}
+
+long log_check(const void *map, size_t size, const char **error) {
+  struct log_header_t want;
+  make_header(&want);
+
+  if (size<sizeof(want) || memcmp(map,want.magic,sizeof(want.magic))!=0) {
+    *error = "not a mathematico log";
+  } else if (memcmp(map,&want,sizeof(want))!=0) {
+    *error = "log of another version, board or byte order";
+  } else if ((size-sizeof(want))%sizeof(struct log_record_t)!=0) {
+    *error = "log ends with an incomplete record";
+  } else {
+    return (long)((size-sizeof(want))/sizeof(struct log_record_t));
+  }
+  return -1;
+}
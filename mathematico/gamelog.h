@@ -0,0 +1,69 @@
+
+/*********************************************************************
+ *
+ * gamelog.h - append-only binary log of mathematico games
+ *
+ * A log is a header followed by records of fixed size, one per game, so
+ * record i is at offset sizeof(header)+i*sizeof(record) and a reader can
+ * map the file and index it directly. A record of a 5x5 game takes 64
+ * bytes; the header tells the size of the board. Numbers are in the
+ * byte order of the machine that wrote them, the header tells which one
+ * that was.
+ *
+ * A record holds the seed, the cards in the order they were dealt, the
+ * cells they were put on and the final scores of the lines. Games that
+ * were ended prematurely have less than COLS*ROWS moves.
+ */
+
+#ifndef GAMELOG_H
+#define GAMELOG_H
+
+#include "engine.h"
+
+#define LOG_MAGIC	"MATHLOG"
+#define LOG_VERSION	1
+
+/* who played the game */
+enum { LOG_UI, LOG_RANDOM, LOG_GREEDY, LOG_HEURISTIC, LOG_SOURCES };
+extern const char *const log_source[LOG_SOURCES];
+
+struct log_header_t {
+  char magic[8];		/* LOG_MAGIC */
+  uint32_t version;		/* LOG_VERSION */
+  uint32_t byte_order;		/* 0x01020304 as written */
+  uint16_t record_size;		/* sizeof(struct log_record_t) */
+  uint8_t cols, rows;		/* of the board */
+  uint8_t reserved[44];
+};
+
+struct log_record_t {
+  uint64_t seed;		/* of game_init() */
+  uint8_t cell[COLS*ROWS];	/* cell x*ROWS+y of move i */
+  uint8_t card[(COLS*ROWS+1)/2];/* card of move i, low nibble first */
+  uint8_t score[LINES];		/* final score of each line */
+  uint16_t total;		/* final score */
+  uint8_t moves;		/* number of moves */
+  uint8_t source;		/* LOG_UI ... */
+  uint8_t reserved[2];
+};
+
+/* card of move i */
+static inline int log_card(const struct log_record_t *r, int i) {
+  return i&1 ? r->card[i/2]>>4 : r->card[i/2]&15;
+}
+
+/* fill in the record of game g */
+void log_fill(struct log_record_t *r, const struct game_t *g, int source);
+
+/* open a log for appending, writes the header of a new one.
+   Returns a file descriptor, or -1 with errno set. */
+int log_open(const char *path);
+
+/* append n records at once, returns 0 or -1 with errno set */
+int log_write(int fd, const struct log_record_t *r, int n);
+
+/* check the header of a mapped log of 'size' bytes, returns the number
+   of records, or -1 with the reason in *error */
+long log_check(const void *map, size_t size, const char **error);
+
+#endif
@@ -1,5 +1,5 @@
 
-int ninst = 23;
+int ninst = 24;
 
 char *inst[] = {
   "Welcome to Mathematico!",	/* 0 */
@@ -23,6 +23,7 @@ char *inst[] = {
   "  1 1 1 1             200",
   "add 10 points to each diagonal score", /* 19 */
   "",
-  "To end prematurely press 'q'.",
+  "Press 'a' for advice on the best cells, 'g' to show the gain of every cell,",
+  "'q' to end prematurely.",
   "Alternatively you can use the vi movement keys."
   };
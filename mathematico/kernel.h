@@ -0,0 +1,80 @@
+
+/*********************************************************************
+ *
+ * kernel.h - score the lines of many boards at once
+ *
+ * Included by mathbatch.c once per instruction set, with
+ *
+ *   KERNEL  name of the function
+ *   TARGET  its target attribute
+ *   V       vector of LANES shorts (GCC vector extension)
+ *   LANES   number of boards, up to BLOCK
+ *
+ * The boards are in structure of arrays layout: cells[x*ROWS+y][lane]
+ * and score[line][lane], the kernel scores LANES of the BLOCK lanes
+ * starting at 'first'. Every lane runs the original rules: sort the
+ * five cells, fill in the empty ones, compare. Branches are replaced
+ * by masks, a comparison gives -1 in every lane where it holds.
+ */
+
+#define SEL(m,a,b)	(((m)&(a))|(~(m)&(b)))
+#define SORT2(a,b)	do { V m_ = (a)<(b); V t_ = SEL(m_,a,b); \
+			     b = SEL(m_,b,a); a = t_; } while (0)
+
+TARGET static void KERNEL(const short cells[COLS*ROWS][BLOCK],
+			  short score[LINES][BLOCK], int first) {
+  static const int line[LINES][5] = {
+    { 0, 1, 2, 3, 4 }, { 5, 6, 7, 8, 9 }, {10,11,12,13,14 },
+    {15,16,17,18,19 }, {20,21,22,23,24 },
+    { 0, 5,10,15,20 }, { 1, 6,11,16,21 }, { 2, 7,12,17,22 },
+    { 3, 8,13,18,23 }, { 4, 9,14,19,24 },
+    { 0, 6,12,18,24 }, {20,16,12, 8, 4 }
+  };
+
+  for (int l=0;l<LINES;l++) {
+    V x0, x1, x2, x3, x4;
+    __builtin_memcpy(&x0,cells[line[l][0]]+first,sizeof(V));
+    __builtin_memcpy(&x1,cells[line[l][1]]+first,sizeof(V));
+    __builtin_memcpy(&x2,cells[line[l][2]]+first,sizeof(V));
+    __builtin_memcpy(&x3,cells[line[l][3]]+first,sizeof(V));
+    __builtin_memcpy(&x4,cells[line[l][4]]+first,sizeof(V));
+
+    /* sorting network for five */
+    SORT2(x0,x1); SORT2(x3,x4); SORT2(x2,x4);
+    SORT2(x2,x3); SORT2(x0,x3); SORT2(x0,x2);
+    SORT2(x1,x4); SORT2(x1,x3); SORT2(x1,x2);
+
+    /* fill zeros with numbers that don't gain score */
+    V zero = x0-x0;
+    x0 = SEL(x0==zero,zero+20,x0);
+    x1 = SEL(x1==zero,zero+22,x1);
+    x2 = SEL(x2==zero,zero+24,x2);
+    x3 = SEL(x3==zero,zero+26,x3);
+    x4 = SEL(x4==zero,zero+28,x4);
+
+    V e01 = x0==x1, e12 = x1==x2, e23 = x2==x3, e34 = x3==x4;
+    V one0 = x0==zero+1, one1 = x1==zero+1, one2 = x2==zero+1;
+    V res = zero;
+
+    res = SEL(e01|e12|e23|e34,zero+10,res);			/* one pair */
+    res = SEL((e01&(e23|e34))|(e12&e34),zero+20,res);		/* two pairs */
+    res = SEL((e12&(e01|e23))|(e23&e34),zero+40,res);		/* 3x same */
+    res = SEL(e01&e34&(e12|e23),zero+80,res);			/* full house */
+    res = SEL(one0&one1&one2&(x3==zero+13)&(x4==zero+13),
+	      zero+100,res);					/* 1 1 1 13 13 */
+    res = SEL(e12&e23&(e01|e34),zero+160,res);			/* 4x same */
+    res = SEL(one0&one1&one2&(x3==zero+1),zero+200,res);	/* 4x one */
+    res = SEL((x0+1==x1)&(x1+1==x2)&(x2+1==x3)&(x3+1==x4),
+	      zero+50,res);					/* street */
+    res = SEL(one0&(x1==zero+10)&(x2==zero+11)&(x3==zero+12)&(x4==zero+13),
+	      zero+150,res);					/* 1 10 11 12 13 */
+
+    /* diagonals earn 10 extra points */
+    if (l>=COLS+ROWS) res += SEL(res>zero,zero+10,zero);
+
+    __builtin_memcpy(score[l]+first,&res,sizeof(V));
+  }
+}
+
+#undef SEL
+#undef SORT2
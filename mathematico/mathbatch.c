@@ -0,0 +1,250 @@
+
+/*********************************************************************
+ *
+ * mathbatch - score a stream of completed mathematico boards
+ *
+ * Usage: mathbatch [-b] [-q] [-k scalar|sse2|avx2] [-r boards] [file]
+ *
+ * Boards are read as COLS*ROWS numbers each, row by row, or with -b in
+ * binary: (COLS*ROWS+1)/2 bytes per board, 13 on 5x5, cell i (row by
+ * row) in the low nibble of byte i/2 if i is even and in the high nibble
+ * otherwise. -r scores random boards instead. For every board, the
+ * scores of its lines are printed in the order of score[] (columns,
+ * rows, diagonals) followed by the total; -q prints only the summary.
+ *
+ * The boards are scored BLOCK at a time with SIMD kernels, see
+ * kernel.h. The kernel is chosen by what the CPU supports, -k forces
+ * one. The scalar kernel uses the table of score.h, and is the only one
+ * for boards other than 5x5.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "engine.h"
+
+#define BLOCK	16		/* boards scored together */
+#define CHUNK	256		/* blocks read at once */
+#define CELLS	(COLS*ROWS)
+
+typedef void (*kernel_t)(const short cells[CELLS][BLOCK], short score[LINES][BLOCK]);
+
+static void score_scalar(const short cells[CELLS][BLOCK], short score[LINES][BLOCK]) {
+  for (int b=0;b<BLOCK;b++) {
+    int board[COLS][ROWS], s[LINES];
+    for (int i=0;i<CELLS;i++) board[i/ROWS][i%ROWS] = cells[i][b];
+    score_board((const int (*)[ROWS])board,s);
+    for (int l=0;l<LINES;l++) score[l][b] = (short)s[l];
+  }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && SIZE==5
+#define HAVE_SIMD
+
+typedef short v8hi __attribute__((vector_size(16)));
+typedef short v16hi __attribute__((vector_size(32)));
+
+#define KERNEL	score_sse2_8
+#define TARGET	__attribute__((target("sse2")))
+#define V	v8hi
+#define LANES	8
+#include "kernel.h"
+#undef KERNEL
+#undef TARGET
+#undef V
+#undef LANES
+
+#define KERNEL	score_avx2_16
+#define TARGET	__attribute__((target("avx2")))
+#define V	v16hi
+#define LANES	16
+#include "kernel.h"
+#undef KERNEL
+#undef TARGET
+#undef V
+#undef LANES
+
+static void score_sse2(const short cells[CELLS][BLOCK], short score[LINES][BLOCK]) {
+  score_sse2_8(cells,score,0);
+  score_sse2_8(cells,score,8);
+}
+
+static void score_avx2(const short cells[CELLS][BLOCK], short score[LINES][BLOCK]) {
+  score_avx2_16(cells,score,0);
+}
+#endif
+
+static const struct {
+  const char *name;
+  kernel_t kernel;
+} kernels[] = {
+#ifdef HAVE_SIMD
+  { "avx2", score_avx2 },
+  { "sse2", score_sse2 },
+#endif
+  { "scalar", score_scalar }
+};
+#define KERNELS ((int)(sizeof(kernels)/sizeof(kernels[0])))
+
+static bool supported(const char *name) {
+#ifdef HAVE_SIMD
+  __builtin_cpu_init();
+  if (strcmp(name,"avx2")==0) return __builtin_cpu_supports("avx2");
+  if (strcmp(name,"sse2")==0) return __builtin_cpu_supports("sse2");
+#endif
+  return strcmp(name,"scalar")==0;
+}
+
+/* input */
+
+static FILE *in;
+static bool binary;
+static long random_boards = -1;
+static struct game_t rng;	/* only its generator */
+
+/* next number of a text stream, -1 at the end */
+static int read_number() {
+  int c;
+  do {
+    c = getc(in);
+  } while (c==' ' || c=='\t' || c=='\n' || c=='\r');
+  if (c==EOF) return -1;
+  if (c<'0' || c>'9') {
+    fprintf(stderr,"mathbatch: unexpected '%c'\n",c);
+    exit(1);
+  }
+  int n = 0;
+  while (c>='0' && c<='9') {
+    n = 10*n+c-'0';
+    c = getc(in);
+  }
+  return n;
+}
+
+/* read a board into lane b, returns false at the end */
+static bool read_board(short cells[CELLS][BLOCK], int b) {
+  if (random_boards>=0) {
+    if (random_boards==0) return false;
+    random_boards--;
+    for (int i=0;i<CELLS;i++) cells[i][b] = (short)(game_random(&rng,CARDS)+1);
+    return true;
+  }
+
+  if (binary) {
+    unsigned char buf[(CELLS+1)/2];
+    size_t n = fread(buf,1,sizeof(buf),in);
+    if (n==0) return false;
+    if (n!=sizeof(buf)) {
+      fprintf(stderr,"mathbatch: incomplete board at the end\n");
+      exit(1);
+    }
+    for (int i=0;i<CELLS;i++) {
+      int c = i&1 ? buf[i/2]>>4 : buf[i/2]&15;
+      if (c>CARDS) {
+	fprintf(stderr,"mathbatch: no card %d\n",c);
+	exit(1);
+      }
+      cells[(i%COLS)*ROWS+i/COLS][b] = (short)c;
+    }
+    return true;
+  }
+
+  for (int i=0;i<CELLS;i++) {
+    int c = read_number();
+    if (c<0 && i==0) return false;
+    if (c<0 || c>CARDS) {
+      fprintf(stderr,"mathbatch: expected %d numbers in 0..%d per board\n",CELLS,CARDS);
+      exit(1);
+    }
+    cells[(i%COLS)*ROWS+i/COLS][b] = (short)c;
+  }
+  return true;
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static void usage() {
+  fprintf(stderr,"usage: mathbatch [-b] [-q] [-k scalar|sse2|avx2] [-r boards] [file]\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  const char *name = NULL;
+  bool quiet = false;
+  int c;
+
+  while ((c = getopt(argc,argv,"bqk:r:"))!=-1) {
+    switch (c) {
+    case 'b': binary = true; break;
+    case 'q': quiet = true; break;
+    case 'k': name = optarg; break;
+    case 'r': random_boards = atol(optarg); break;
+    default: usage();
+    }
+  }
+  if (argc-optind>1 || (random_boards>=0 && optind<argc)) usage();
+
+  int k;
+  for (k=0;k<KERNELS;k++)
+    if (name==NULL ? supported(kernels[k].name) : strcmp(name,kernels[k].name)==0)
+      break;
+  if (k==KERNELS || !supported(kernels[k].name)) {
+    fprintf(stderr,"mathbatch: kernel %s is not supported\n",name);
+    return 1;
+  }
+  kernel_t kernel = kernels[k].kernel;
+
+  in = stdin;
+  if (optind<argc && (in = fopen(argv[optind],binary?"rb":"r"))==NULL) {
+    perror(argv[optind]);
+    return 1;
+  }
+  game_init(&rng,1);
+
+  /* read many blocks at once, so the timer sees only the kernel */
+  static short cells[CHUNK][CELLS][BLOCK] __attribute__((aligned(32)));
+  static short score[CHUNK][LINES][BLOCK] __attribute__((aligned(32)));
+  long boards = 0;
+  double sum = 0, seconds = 0, start = now();
+  bool more = true;
+
+  while (more) {
+    int n;
+    for (n=0;n<CHUNK*BLOCK;n++)
+      if (!(more = read_board(cells[n/BLOCK],n%BLOCK))) break;
+    if (n==0) break;
+    for (int b=n;b%BLOCK!=0;b++)
+      for (int i=0;i<CELLS;i++) cells[b/BLOCK][i][b%BLOCK] = 0;
+
+    double t = now();
+    for (int j=0;j<(n+BLOCK-1)/BLOCK;j++)
+      kernel((const short (*)[BLOCK])cells[j],score[j]);
+    seconds += now()-t;
+
+    for (int b=0;b<n;b++) {
+      short (*s)[BLOCK] = score[b/BLOCK];
+      int total = 0;
+      for (int l=0;l<LINES;l++) {
+	total += s[l][b%BLOCK];
+	if (!quiet) printf("%d ",s[l][b%BLOCK]);
+      }
+      if (!quiet) printf("%d\n",total);
+      sum += total;
+    }
+    boards += n;
+  }
+
+  fprintf(stderr,"boards %ld, kernel %s, mean score %.2f\n",boards,kernels[k].name,
+	  boards ? sum/boards : 0.0);
+  fprintf(stderr,"scoring %.0f boards/s, overall %.0f boards/s\n",
+	  seconds>0 ? boards/seconds : 0.0,boards/(now()-start));
+  return 0;
+}
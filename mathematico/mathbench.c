@@ -0,0 +1,394 @@
+
+/*********************************************************************
+ *
+ * mathbench - speed of the mathematico scoring, checked against the
+ *             original rules
+ *
+ * Usage: mathbench [-s seed] [-m milliseconds]
+ *
+ * First every line of five cells in every order is scored by the table
+ * and by the frozen eval_five() of reference.h, then the boards of all
+ * sets and the scores the engine keeps up to date during whole games.
+ * Any difference is reported on stderr and makes the exit status 1: a
+ * new scorer doesn't ship unless this passes. The comparison with the
+ * reference needs a 5x5 build; other sizes only check the engine
+ * against score_board().
+ *
+ * Then the time per call is measured, best of ROUNDS rounds of the
+ * given milliseconds, on sets of lines and boards made from the seed:
+ * realistic ones (dealt from a deck, boards of played games) and
+ * adversarial ones (empty lines, full houses, streets, four of a
+ * kind). Whole games are timed with the random and the greedy policy.
+ * The results go to stdout as JSON, to compare builds.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "policy.h"
+#include "reference.h"
+
+#define SET	4096		/* lines or boards per set */
+#define ROUNDS	5
+#define N	COLS		/* cells of a line */
+
+static struct game_t rng;	/* only its generator */
+static double budget = 0.1;	/* seconds per round */
+static volatile long sink;	/* keeps the results alive */
+static long mismatches;
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+/* nanoseconds per evaluation of expr, for i over a set, best of ROUNDS */
+#define MEASURE(result, expr) do {				\
+    double best_ = 1e30;					\
+    for (int r_=0;r_<ROUNDS;r_++) {				\
+      long n_ = 0, acc_ = 0;					\
+      double t_ = now(), d_;					\
+      do {							\
+	for (int i=0;i<SET;i++) acc_ += (expr);			\
+	n_ += SET;						\
+      } while ((d_ = now()-t_)<budget);				\
+      sink += acc_;						\
+      if (d_/n_<best_) best_ = d_/n_;				\
+    }								\
+    result = best_*1e9;						\
+  } while (0)
+
+/* lines */
+
+static int random_card() {
+  return (int)game_random(&rng,CARDS)+1;
+}
+
+static void shuffle(int *x, int n) {
+  for (int i=n-1;i>0;i--) {
+    int j = (int)game_random(&rng,(uint32_t)i+1), t = x[i];
+    x[i] = x[j];
+    x[j] = t;
+  }
+}
+
+/* n cards from a fresh deck */
+static void deal(int *x, int n) {
+  int deck[CARDS*COPIES];
+  for (int i=0;i<CARDS*COPIES;i++) deck[i] = i%CARDS+1;
+  shuffle(deck,CARDS*COPIES);
+  memcpy(x,deck,(size_t)n*sizeof(int));
+}
+
+/* a line that starts with the given five cards, filled up or cut to N */
+static void make_line(int *x, int a, int b, int c, int d, int e) {
+  int five[5] = { a, b, c, d, e };
+  for (int i=0;i<N;i++) x[i] = i<5 ? five[i] : random_card();
+  shuffle(x,N);
+}
+
+static void line_dealt(int *x) {
+  deal(x,N);
+}
+
+/* as in a game: some cells still empty */
+static void line_partial(int *x) {
+  deal(x,N);
+  int empty = (int)game_random(&rng,N);
+  for (int i=0;i<empty;i++) x[i] = 0;
+  shuffle(x,N);
+}
+
+static void line_random(int *x) {
+  for (int i=0;i<N;i++) x[i] = (int)game_random(&rng,RANKS);
+}
+
+static void line_empty(int *x) {
+  for (int i=0;i<N;i++) x[i] = 0;
+}
+
+static void line_full_house(int *x) {
+  int a = random_card(), b = random_card();
+  if (game_random(&rng,8)==0) {
+    a = 1;
+    b = 13;
+  }
+  make_line(x,a,a,a,b,b);
+}
+
+static void line_street(int *x) {
+  int a = random_card()%9+1;
+  if (game_random(&rng,4)==0)
+    make_line(x,1,10,11,12,13);
+  else
+    make_line(x,a,a+1,a+2,a+3,a+4);
+}
+
+static void line_four(int *x) {
+  int a = game_random(&rng,4)==0 ? 1 : random_card();
+  make_line(x,a,a,a,a,random_card());
+}
+
+static const struct {
+  const char *name;
+  void (*make)(int *x);
+} line_sets[] = {
+  { "dealt", line_dealt },
+  { "partial", line_partial },
+  { "random", line_random },
+  { "empty", line_empty },
+  { "full_house", line_full_house },
+  { "street", line_street },
+  { "four", line_four }
+};
+#define LINE_SETS ((int)(sizeof(line_sets)/sizeof(line_sets[0])))
+
+static int table_line(const int *x) {
+  uint64_t h = 0;
+  for (int i=0;i<N;i++) h += score_bit[x[i]];
+  return hand_score[hand_of_hist(h)];
+}
+
+#if SIZE==5
+static int reference_line(const int *x) {
+  return eval_five(x[0],x[1],x[2],x[3],x[4]);
+}
+#endif
+
+/* boards */
+
+struct board_t {
+  int cell[COLS][ROWS];
+};
+
+/* a board at the end, or after 'moves' moves, of a greedy game */
+static void board_played(struct board_t *b, int moves) {
+  struct game_t g;
+  game_init(&g,(uint64_t)game_random(&rng,UINT32_MAX));
+  while (g.filled<moves) {
+    int x, y;
+    game_deal(&g);
+    choose_cell(&g,rate_gain,&x,&y);
+    game_place(&g,x,y,g.card);
+  }
+  memcpy(b->cell,g.board,sizeof(b->cell));
+}
+
+static void board_end(struct board_t *b) {
+  board_played(b,COLS*ROWS);
+}
+
+static void board_partial(struct board_t *b) {
+  board_played(b,(int)game_random(&rng,COLS*ROWS));
+}
+
+static void board_random(struct board_t *b) {
+  for (int x=0;x<COLS;x++)
+    for (int y=0;y<ROWS;y++) b->cell[x][y] = (int)game_random(&rng,RANKS);
+}
+
+static void board_empty(struct board_t *b) {
+  memset(b->cell,0,sizeof(b->cell));
+}
+
+/* every column a full house, street or four of a kind */
+static void board_adversarial(struct board_t *b) {
+  static void (*const make[3])(int *x) = { line_full_house, line_street, line_four };
+  for (int x=0;x<COLS;x++) make[game_random(&rng,3)](b->cell[x]);
+}
+
+static const struct {
+  const char *name;
+  void (*make)(struct board_t *b);
+} board_sets[] = {
+  { "played", board_end },
+  { "partial", board_partial },
+  { "random", board_random },
+  { "empty", board_empty },
+  { "adversarial", board_adversarial }
+};
+#define BOARD_SETS ((int)(sizeof(board_sets)/sizeof(board_sets[0])))
+
+static int table_board(const struct board_t *b) {
+  int score[LINES];
+  return score_board((const int (*)[ROWS])b->cell,score);
+}
+
+#if SIZE==5
+static int reference_board(const struct board_t *b) {
+  int score[LINES], total = 0;
+  eval_board((const int (*)[ROWS])b->cell,score);
+  for (int l=0;l<LINES;l++) total += score[l];
+  return total;
+}
+#endif
+
+/* check */
+
+static void mismatch(const char *what, const int *x, int n, int want, int have) {
+  if (mismatches++<10) {
+    fprintf(stderr,"mathbench: %s",what);
+    for (int i=0;i<n;i++) fprintf(stderr," %d",x[i]);
+    fprintf(stderr,": %d instead of %d\n",have,want);
+  }
+}
+
+/* every line of five in every order, returns their number */
+static long check_lines() {
+#if SIZE==5
+  long lines = 0;
+  int x[5];
+  for (long i=0;i<RANKS*RANKS*RANKS*RANKS*RANKS;i++) {
+    long n = i;
+    for (int j=0;j<5;j++) {
+      x[j] = (int)(n%RANKS);
+      n /= RANKS;
+    }
+    int want = reference_line(x), have = table_line(x);
+    if (want!=have) mismatch("line",x,5,want,have);
+    lines++;
+  }
+  return lines;
+#else
+  return 0;
+#endif
+}
+
+static void check_board(const int board[COLS][ROWS]) {
+#if SIZE==5
+  int want[LINES], have[LINES];
+  eval_board(board,want);
+  score_board(board,have);
+  for (int l=0;l<LINES;l++)
+    if (want[l]!=have[l]) mismatch("board",&board[0][0],COLS*ROWS,want[l],have[l]);
+#else
+  (void)board;
+#endif
+}
+
+/* the scores kept by the engine after every move of greedy games */
+static long check_games(int games) {
+  for (int i=0;i<games;i++) {
+    struct game_t g;
+    game_init(&g,(uint64_t)i);
+    while (!game_finished(&g)) {
+      int x, y, score[LINES];
+      game_deal(&g);
+      choose_cell(&g,rate_gain,&x,&y);
+      game_place(&g,x,y,g.card);
+      int total = score_board((const int (*)[ROWS])g.board,score);
+      if (total!=g.total || memcmp(score,g.score,sizeof(score))!=0)
+	mismatch("game",&g.board[0][0],COLS*ROWS,total,g.total);
+      check_board((const int (*)[ROWS])g.board);
+    }
+  }
+  return games;
+}
+
+/* output */
+
+static void print_ns(const char *name, double reference, double table, bool last) {
+  printf("    \"%s\": { ",name);
+  if (reference>0)
+    printf("\"reference\": %.2f, ",reference);
+  else
+    printf("\"reference\": null, ");
+  printf("\"table\": %.2f }%s\n",table,last ? "" : ",");
+}
+
+static void usage() {
+  fprintf(stderr,"usage: mathbench [-s seed] [-m milliseconds]\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  uint64_t seed = 1;
+  int c;
+
+  while ((c = getopt(argc,argv,"s:m:"))!=-1) {
+    switch (c) {
+    case 's': seed = strtoull(optarg,NULL,0); break;
+    case 'm': budget = atof(optarg)/1000; break;
+    default: usage();
+    }
+  }
+  if (budget<=0 || optind<argc) usage();
+
+  static int lines[SET][N];
+  static struct board_t boards[SET];
+
+  /* check first */
+  long checked_lines = check_lines();
+  long checked_boards = 0;
+  game_init(&rng,seed);
+  for (int s=0;s<BOARD_SETS;s++) {
+    for (int i=0;i<SET;i++) {
+      board_sets[s].make(&boards[i]);
+      check_board((const int (*)[ROWS])boards[i].cell);
+    }
+    if (SIZE==5) checked_boards += SET;
+  }
+  long checked_games = check_games(1000);
+
+  printf("{\n");
+  printf("  \"size\": %d,\n",SIZE);
+  printf("  \"seed\": %llu,\n",(unsigned long long)seed);
+  printf("  \"check\": { \"reference\": %s, \"lines\": %ld, \"boards\": %ld, "
+	 "\"games\": %ld, \"mismatches\": %ld },\n",SIZE==5 ? "true" : "false",
+	 checked_lines,checked_boards,checked_games,mismatches);
+
+  /* each set is made from the seed alone, whatever was measured before */
+  printf("  \"line_ns\": {\n");
+  for (int s=0;s<LINE_SETS;s++) {
+    double reference = 0, table;
+    game_init(&rng,seed+(uint64_t)s);
+    for (int i=0;i<SET;i++) line_sets[s].make(lines[i]);
+#if SIZE==5
+    MEASURE(reference,reference_line(lines[i]));
+#endif
+    MEASURE(table,table_line(lines[i]));
+    print_ns(line_sets[s].name,reference,table,s==LINE_SETS-1);
+  }
+  printf("  },\n");
+
+  printf("  \"board_ns\": {\n");
+  for (int s=0;s<BOARD_SETS;s++) {
+    double reference = 0, table;
+    game_init(&rng,seed+(uint64_t)s);
+    for (int i=0;i<SET;i++) board_sets[s].make(&boards[i]);
+#if SIZE==5
+    MEASURE(reference,reference_board(&boards[i]));
+#endif
+    MEASURE(table,table_board(&boards[i]));
+    print_ns(board_sets[s].name,reference,table,s==BOARD_SETS-1);
+  }
+  printf("  },\n");
+
+  printf("  \"games\": {\n");
+  for (int p=0;p<2;p++) {
+    rating_t rate = p ? rate_gain : NULL;
+    double best = 1e30;
+    for (int r=0;r<ROUNDS;r++) {
+      long n = 0;
+      double t = now(), d;
+      do {
+	struct game_t g;
+	game_init(&g,seed+(uint64_t)n++);
+	play_out(&g,rate);
+	sink += game_total(&g);
+      } while ((d = now()-t)<budget);
+      if (d/n<best) best = d/n;
+    }
+    printf("    \"%s\": { \"ns\": %.0f, \"games_per_s\": %.0f }%s\n",
+	   p ? "greedy" : "random",best*1e9,1/best,p ? "" : ",");
+  }
+  printf("  }\n");
+  printf("}\n");
+
+  return mismatches ? 1 : 0;
+}
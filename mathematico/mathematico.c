@@ -7,6 +7,7 @@
  * 1.1    dz  2000-04-30	linted, colors
  * 1.2    dz  2015-02-22        refactored, instructions in game
  * 1.2.1  dz  2015-11-03        score bug fixed
+ * 1.3        2026-10-18        table driven scoring, rules in engine.c
  *
  * Copyright (c) 2000+2015 Derik van Zuetphen <dz@426.ch>
  * All rights reserved.
@@ -34,23 +35,36 @@
  * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
 #include <ncurses.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include "advice.h"
+#include "engine.h"
+#include "gamelog.h"
 
-#define VERSION "1.2.1"
-
-/* board */
-#define ROWS	5
-#define COLS	5
-
-int board[COLS][ROWS];
-int score[COLS+ROWS+2];         /* order: columns, rows, diag[x][x], diag[x][5-x] */
+#define VERSION "1.3"
 
-int card;			/* current card */
+struct game_t game;		/* the game on screen */
 int xpos,ypos;			/* current cursor */
-int drawn_cards[13];	        /* number of drawn cards */
+double advice_budget = 10;	/* seconds to search for advice */
+bool advised;			/* advice asked for the current card */
+bool heatmap;			/* show the gain of the card on the empty cells */
+int gain[COLS][ROWS];		/* change of the total, if the card went there */
+int best_gain;
+int log_fd = -1;		/* game log, see gamelog.h */
+
+/* screen layout, see layout() */
+#define CELL_W	6		/* columns per cell, including the frame */
+int xofs,yofs;			/* top left corner of the board */
+int cell_h;			/* rows per cell, including the frame */
+int score_x,score_y;		/* column of the row scores, row of the column scores */
 
 /* colors */
 #define BG	COLOR_BLACK
@@ -65,15 +79,67 @@ int drawn_cards[13];	        /* number of drawn cards */
 #define P_HELP   7
 #define P_GAMEOVER_FRAME 8
 #define P_GAMEOVER_TEXT  9
+#define P_HEAT_NONE 10
+#define P_HEAT      11
+#define P_HEAT_BEST 12
 
 /* instructions */
 extern int ninst;
 extern char *inst[];
 
-void display_board() {
-  const int xofs = 17;
-  const int yofs = 4;
+/*
+ * Rendering: the print functions only draw into stdscr. frame() sends
+ * what changed since the last frame to the terminal in one go, once per
+ * input event, just before waiting for the next key.
+ */
+
+long frames;			/* sent to the terminal */
+long frame_bytes;		/* their size, -1 if unknown */
+long max_frame_bytes;
+bool stats;			/* print them at the end */
+
+/* bytes written by the process so far, from /proc/self/io of Linux;
+   -1 elsewhere */
+long bytes_written() {
+  static int fd = -2;
+  char buf[1024];
+
+  if (fd==-2) fd = open("/proc/self/io",O_RDONLY);
+  if (fd<0) return -1;
+  ssize_t n = pread(fd,buf,sizeof(buf)-1,0);
+  if (n<=0) return -1;
+  buf[n] = 0;
+  char *w = strstr(buf,"wchar:");
+  return w ? atol(w+6) : -1;
+}
+
+void frame() {
+  if (!is_wintouched(stdscr)) return;
+  long before = bytes_written();
+  move(23,0);
+  wnoutrefresh(stdscr);
+  doupdate();
+  long bytes = bytes_written()-before;
 
+  frames++;
+  if (before<0 || frame_bytes<0) {
+    frame_bytes = -1;
+  } else {
+    frame_bytes += bytes;
+    if (bytes>max_frame_bytes) max_frame_bytes = bytes;
+  }
+}
+
+/* fit the board of any size between the title and the side panel */
+void layout() {
+  cell_h = ROWS<=5 ? 3 : 2;
+  xofs = COLS<=5 ? 17 : 51-CELL_W*COLS;
+  yofs = 4;
+  score_x = xofs+CELL_W*COLS+1;
+  score_y = yofs+cell_h*ROWS+1;
+}
+
+void display_board() {
   clear();
   color_set(P_TITLE,NULL);
   mvprintw(0,56,"[ ? for instructions ]");
@@ -81,63 +147,34 @@ void display_board() {
   mvprintw(1,73,VERSION);
   mvprintw(1,24,"M a t h e m a t i c o");
   color_set(P_LINE,NULL);
-  mvprintw(yofs,xofs,"+-----+-----+-----+-----+-----+");
-  for (int y=0;y<ROWS;y++) {
-    mvprintw(yofs+3*y+1,xofs,"|     |     |     |     |     |");
-    mvprintw(yofs+3*y+2,xofs,"|     |     |     |     |     |");
-    mvprintw(yofs+3*y+3,xofs,"+-----+-----+-----+-----+-----+");
+  for (int y=0;y<=cell_h*ROWS;y++) {
+    move(yofs+y,xofs);
+    for (int x=0;x<COLS;x++) addstr(y%cell_h ? "|     " : "+-----");
+    addstr(y%cell_h ? "|" : "+");
   }
-  refresh();
-}
-
-void init_board() {
-  for (int x=0;x<COLS;x++) {
-    for (int y=0;y<ROWS;y++) {
-      board[x][y] = 0;
-    }
-  }
-  for (int x=0;x<COLS+ROWS+2;x++) score[x] = 0;
-  for (int x=0;x<13;x++) drawn_cards[x]=0;
-}
-
-int total_score() {
-  int total = 0;
-  for (int i=0;i<COLS+ROWS+2;i++)
-    total += score[i];
-  return total;
 }
 
 void print_score() {
   color_set(P_POINT,NULL);
   for (int i=0;i<COLS;i++) {
-    mvprintw(20,18+6*i,"%3d",score[i]);
+    mvprintw(score_y,xofs+1+CELL_W*i,"%3d",game.score[i]);
   }
   for (int i=COLS;i<COLS+ROWS;i++) {
-    mvprintw(6+3*(i-COLS),48,"%3d",score[i]);
+    mvprintw(yofs+cell_h*(i-COLS+1)-1,score_x,"%3d",game.score[i]);
   }
-  mvprintw(20,48,"%3d",score[COLS+ROWS]);
-  mvprintw(3,48,"%3d",score[COLS+ROWS+1]);
+  mvprintw(score_y,score_x,"%3d",game.score[COLS+ROWS]);
+  mvprintw(yofs-1,score_x,"%3d",game.score[COLS+ROWS+1]);
 
   color_set(P_SIDE,NULL);
 
   mvprintw(15,64,"total score");
-  mvprintw(17,64,"%5d",total_score());
-  refresh();
+  mvprintw(17,64,"%5d",game_total(&game));
 }
 
 void display_next_card() {
   color_set(P_SIDE,NULL);
   mvprintw(8,64,"next card");
-  mvprintw(10,67,"%2d",card);
-  refresh();
-}
-
-void get_card() {
-  do {
-    card = rand()%13+1;
-  } while (drawn_cards[card]>=4);
-  drawn_cards[card]++;
-  display_next_card();
+  mvprintw(10,67,"%2d",game.card);
 }
 
 /* if 'n' contains the digit '1' */
@@ -146,20 +183,26 @@ int highlight_number(int n) {
 }
 
 void print_card(int x, int y) {
+  int top = yofs+cell_h*y+1, left = xofs+1+CELL_W*x;
+
   color_set(P_NUM,NULL);
-  if (board[x][y]!=0) {
-    if (highlight_number(board[x][y]))
+  if (game.board[x][y]!=0) {
+    if (highlight_number(game.board[x][y]))
       color_set(P_NUM_HL,NULL);
     else
       color_set(P_NUM,NULL);
-    mvprintw(5+3*y,18+6*x,"     ");
-    mvprintw(6+3*y,18+6*x," %2d  ",board[x][y]);
+  }
+  for (int i=top;i<top+cell_h-2;i++)
+    mvprintw(i,left,"     ");
+  if (game.board[x][y]!=0) {
+    mvprintw(top+cell_h-2,left," %2d  ",game.board[x][y]);
+  } else if (heatmap && game.card!=0) {
+    int g = gain[x][y];
+    color_set(g<=0 ? P_HEAT_NONE : g==best_gain ? P_HEAT_BEST : P_HEAT,NULL);
+    mvprintw(top+cell_h-2,left,"%+4d ",g);
   } else {
-    mvprintw(5+3*y,18+6*x,"     ");
-    mvprintw(6+3*y,18+6*x,"     ");
+    mvprintw(top+cell_h-2,left,"     ");
   }
-  move(23,0);
-  refresh();
 }
 
 void cursor (bool on) {
@@ -168,7 +211,54 @@ void cursor (bool on) {
   print_card(xpos,ypos);
   if(on)
     attroff(A_REVERSE);
-  refresh();
+}
+
+/* what-if of the card on every empty cell, from the histograms of the lines */
+void update_gains() {
+  best_gain = 0;
+  for (int x=0;x<COLS;x++) {
+    for (int y=0;y<ROWS;y++) {
+      gain[x][y] = game.board[x][y]==0 ? game_gain(&game,x,y,game.card) : 0;
+      if (gain[x][y]>best_gain) best_gain = gain[x][y];
+    }
+  }
+}
+
+void print_gains() {
+  for (int x=0;x<COLS;x++) {
+    for (int y=0;y<ROWS;y++) {
+      if (game.board[x][y]==0) print_card(x,y);
+    }
+  }
+  cursor(true);
+}
+
+void get_card() {
+  game_deal(&game);
+  display_next_card();
+  update_gains();
+  if (heatmap) print_gains();
+}
+
+/* clear the advice area */
+void clear_advice() {
+  for (int y=19;y<24;y++)
+    mvprintw(y,56,"%24s","");
+}
+
+/* show the best cells found so far */
+void print_advice() {
+  struct advice_t best[3];
+  double rate;
+  int n = advice_ranking(best,3,&rate);
+
+  clear_advice();
+  color_set(P_SIDE,NULL);
+  mvprintw(19,56,"advice %s",advice_running()?"...":"");
+  mvprintw(20,56,"%8.0f rollouts/s",rate);
+  for (int i=0;i<n;i++)
+    mvprintw(21+i,56,"c%d r%d %6.1f +-%5.1f",best[i].x+1,best[i].y+1,
+	     best[i].mean,best[i].ci);
 }
 
 static void show_instructions() {
@@ -177,9 +267,12 @@ static void show_instructions() {
   for (int y=0;y<ninst;y++) {
     mvprintw(y,0,inst[y]);
   }
-  refresh();
+  frame();
 
+  /* wait for a key, also while the advice is polled every 250 ms */
+  timeout(-1);
   getch();
+  timeout(advice_running() ? 250 : -1);
 
   /* rebuild screen */
   display_board();
@@ -190,6 +283,7 @@ static void show_instructions() {
   }
   print_score();
   display_next_card();
+  if (advised) print_advice();
   cursor(true);
 }
 
@@ -198,7 +292,16 @@ bool place_card() {
   bool quit = false;			/* end of game requested */
   cursor(true);
   while (!end) {
+    /* wake up now and then to show the advice */
+    bool advising = advice_running();
+    timeout(advising ? 250 : -1);
+    frame();
     int c = getch();
+    if (advising) {
+      /* out of time: wait for the last batches, then show them once */
+      if (!advice_running()) advice_stop();
+      print_advice();
+    }
     switch(c) {
     case KEY_DOWN:
     case 14:
@@ -231,111 +334,39 @@ bool place_card() {
     case KEY_ENTER:
     case 13:
     case ' ':
-      if (board[xpos][ypos]==0) {
+      if (game.board[xpos][ypos]==0) {
+	advice_stop();
+	advised = false;
+	clear_advice();
 	cursor(false);
-	board[xpos][ypos]=card;
+	game_place(&game,xpos,ypos,game.card);
 	print_card(xpos,ypos);
 	end = true;
       }
       break;
+    case 'g':
+      heatmap = !heatmap;
+      print_gains();
+      break;
+    case 'a':
+      advice_start(&game,advice_budget);
+      advised = true;
+      print_advice();
+      break;
     case '?':
       show_instructions();
       break;
     case 'q':
+      advice_stop();
       end = true;
       quit = true;
       break;
     }
   }
+  timeout(-1);
   return quit;
 }
 
-int eval_five(int a, int b, int c, int d, int e) {
-  int res = 0;
-  int x[5];
-
-  x[0]=a; x[1]=b; x[2]=c; x[3]=d; x[4]=e;
-
-  /* sort x[] */
-  for (int i=0;i<4;i++)
-    for (int j=i+1;j<5;j++)
-      if (x[i]>x[j]) {
-	int tmp=x[i];
-	x[i]=x[j];
-	x[j]=tmp;
-      }
-
-  /* fill zeros in x[] with numbers that don't gain score */
-  int value = 20;
-  for (int i=0;i<5;i++) {
-    if (x[i]==0) x[i]=value;
-    value+=2;
-  }
-
-  /* one pair */
-  if ((x[0]==x[1])||(x[1]==x[2])||(x[2]==x[3])||(x[3]==x[4]))
-    res=10;
-
-  /* two pairs */
-  if (((x[0]==x[1])&&((x[2]==x[3])||(x[3]==x[4])))
-      ||((x[1]==x[2])&&(x[3]==x[4])))
-    res=20;
-
-  /* 3x same */
-  if (((x[1]==x[2])&&((x[0]==x[1])||(x[2]==x[3])))
-      ||((x[2]==x[3])&&(x[3]==x[4])))
-    res=40;
-
-  /* full house */
-  if ((x[0]==x[1])&&(x[3]==x[4])&&((x[2]==x[1])||(x[2]==x[3])))
-    res=80;
-
-  /* full house out of 1 and 13 */
-  if ((x[0]==1)&&(x[1]==1)&&(x[2]==1)&&(x[3]==13)&&(x[4]==13))
-    res=100;
-
-  /* 4x same */
-  if ((x[1]==x[2])&&(x[2]==x[3])&&((x[0]==x[1])||(x[3]==x[4])))
-    res=160;
-
-  /* 4x one */
-  if ((x[0]==1)&&(x[1]==1)&&(x[2]==1)&&(x[3]==1))
-    res=200;
-
-  /* street */
-  if ((x[0]+1==x[1])&&(x[1]+1==x[2])&&(x[2]+1==x[3])&&(x[3]+1==x[4]))
-    res=50;
-
-  /* 1,10,11,12,13 */
-  if ((x[0]==1)&&(x[1]==10)&&(x[2]==11)&&(x[3]==12)&&(x[4]==13))
-    res=150;
-
-  return res;
-}
-
-bool eval_board() {
-  for (int i=0;i<COLS;i++) {
-    score[i] = eval_five(board[i][0],board[i][1],board[i][2],board[i][3],board[i][4]);
-  }
-  for (int i=0;i<ROWS;i++) {
-    score[COLS+i] = eval_five(board[0][i],board[1][i],board[2][i],board[3][i],board[4][i]);
-  }
-
-  int diag_score;
-  diag_score = eval_five(board[0][0],board[1][1],board[2][2],board[3][3],board[4][4]);
-  score[COLS+ROWS] = diag_score>0? 10+diag_score : 0;
-
-  diag_score = eval_five(board[4][0],board[3][1],board[2][2],board[1][3],board[0][4]);
-  score[COLS+ROWS+1] = diag_score>0? 10+diag_score : 0;
-
-  int cnt = 0;
-  for (int i=0;i<ROWS;i++)
-    for (int j=0;j<COLS;j++)
-      if (board[j][i]!=0) cnt++;
-
-  return (cnt==ROWS*COLS);	/* true, if end of game */
-}
-
 void game_over() {
   color_set(P_GAMEOVER_FRAME, NULL);
   attron(A_BOLD);
@@ -346,19 +377,37 @@ void game_over() {
 
   color_set(P_GAMEOVER_TEXT, NULL);
   mvprintw(22,31,"G A M E   O V E R");
-  refresh();
+  frame();
   getch();
 
-  mvprintw(22,25,"Your final score is %d points.", total_score());
+  mvprintw(22,25,"Your final score is %d points.", game_total(&game));
   attroff(A_BOLD);
-  refresh();
+  frame();
   getch();
 }
 
 /*ARGSUSED 1*/
 int main(int argc,char **argv) {
-  /* show help */
-  if (argc>1) {
+  /* -a seconds: time budget of the advice, -l file: append the game
+     to a log, -s: statistics of the screen output at the end, anything
+     else shows help */
+  int opt;
+  while ((opt = getopt(argc,argv,"a:l:s"))!=-1) {
+    if (opt=='a' && atof(optarg)>0) {
+      advice_budget = atof(optarg);
+    } else if (opt=='s') {
+      stats = true;
+    } else if (opt=='l') {
+      if ((log_fd = log_open(optarg))<0) {
+	perror(optarg);
+	exit(1);
+      }
+    } else {
+      argc = 0;
+      break;
+    }
+  }
+  if (argc==0 || optind<argc) {
     for (int y=0;y<ninst;y++) {
       printf("%s\n",inst[y]);
     }
@@ -384,11 +433,14 @@ int main(int argc,char **argv) {
   init_pair(P_HELP,COLOR_YELLOW,BG);
   init_pair(P_GAMEOVER_FRAME,COLOR_YELLOW,BG);
   init_pair(P_GAMEOVER_TEXT,COLOR_WHITE,BG);
+  init_pair(P_HEAT_NONE,COLOR_BLUE,BG);
+  init_pair(P_HEAT,COLOR_YELLOW,BG);
+  init_pair(P_HEAT_BEST,COLOR_GREEN,BG);
 
   /* init game */
-  srand((unsigned)time(NULL));
+  layout();
   xpos=ypos=0;
-  init_board();
+  game_init(&game,(uint64_t)time(NULL));
   display_board();
   print_score();
 
@@ -397,16 +449,28 @@ int main(int argc,char **argv) {
   while (!endofgame) {
     get_card();
     endofgame = place_card();
-    endofgame |= eval_board();
+    endofgame |= game_finished(&game);
     print_score();
   }
+  if (log_fd>=0) {
+    struct log_record_t r;
+    log_fill(&r,&game,LOG_UI);
+    log_write(log_fd,&r,1);
+    close(log_fd);
+  }
   game_over();
 
   /* finish curses  */
   curs_set(1);
-  move(23,0);
-  refresh();
+  frame();
   endwin();
 
+  if (stats) {
+    if (frame_bytes>=0)
+      printf("%ld frames, %ld bytes, %.0f bytes per frame, at most %ld\n",
+	     frames,frame_bytes,frames ? (double)frame_bytes/frames : 0.0,max_frame_bytes);
+    else
+      printf("%ld frames, bytes unknown, counted on Linux only\n",frames);
+  }
   return 0;
 }
@@ -0,0 +1,297 @@
+
+/*********************************************************************
+ *
+ * mathlog - statistics of a mathematico game log
+ *
+ * Usage: mathlog [-t threads] [-s source] [-q summary|first|steps] log
+ *
+ * The log (see gamelog.h) is mapped into memory and split into one
+ * chunk per thread; every thread tallies its chunk and the tallies are
+ * added up at the end. Only complete games are counted, -s restricts
+ * them to those of one source (ui, random, greedy, heuristic).
+ *
+ *   summary  mean score of every line and frequency of the hand types
+ *   first    by the first card: mean score, of its column and row, and
+ *            of the other columns
+ *   steps    frequency of the hand types by the move that completed
+ *            the line
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "gamelog.h"
+
+#define CELLS	(COLS*ROWS)
+
+struct tally_t {
+  long games;			/* complete ones */
+  long bad;			/* complete ones that make no sense, not counted */
+  long sources[LOG_SOURCES];	/* all games, also incomplete ones */
+  double total;
+  double line[LINES];
+  long hands[HANDS];
+  long first[CARDS+1];		/* games by the first card */
+  double first_total[CARDS+1];
+  double first_col[CARDS+1], first_row[CARDS+1], other_col[CARDS+1];
+  long steps[CELLS][HANDS];	/* lines by move that completed them */
+};
+
+struct worker_t {
+  pthread_t thread;
+  const struct log_record_t *first, *last;
+  struct tally_t t;
+};
+
+static int only = -1;		/* source to count, -1 for all */
+static int hand_of[2][256];	/* hand of a line score, [1] for diagonals */
+static int line_of[CELLS][4];	/* lines through a cell, -1 terminated */
+
+static void init_tables() {
+  for (int i=0;i<256;i++) hand_of[0][i] = hand_of[1][i] = -1;
+  for (int h=0;h<HANDS;h++) {
+    hand_of[0][hand_score[h]] = h;
+    hand_of[1][hand_diag_score[h]] = h;
+  }
+  for (int x=0;x<COLS;x++) {
+    for (int y=0;y<ROWS;y++) {
+      int *l = line_of[x*ROWS+y];
+      *l++ = x;
+      *l++ = COLS+y;
+      if (x==y) *l++ = COLS+ROWS;
+      if (x==COLS-1-y) *l++ = COLS+ROWS+1;
+      if (l<line_of[x*ROWS+y]+4) *l = -1;
+    }
+  }
+}
+
+/* true, if the cards, cells and line scores of a complete game can be
+   used as indices: a log with a good header may still be damaged */
+static bool valid(const struct log_record_t *r) {
+  bool used[CELLS] = { false };
+
+  for (int i=0;i<CELLS;i++) {
+    int c = log_card(r,i);
+    if (c<1 || c>CARDS || r->cell[i]>=CELLS || used[r->cell[i]]) return false;
+    used[r->cell[i]] = true;
+  }
+  for (int l=0;l<LINES;l++)
+    if (hand_of[l>=COLS+ROWS][r->score[l]]<0) return false;
+  return true;
+}
+
+static void tally(struct tally_t *t, const struct log_record_t *r) {
+  if (r->source<LOG_SOURCES) t->sources[r->source]++;
+  if (r->moves!=CELLS || (only>=0 && r->source!=only)) return;
+  if (!valid(r)) {
+    t->bad++;
+    return;
+  }
+
+  t->games++;
+  t->total += r->total;
+
+  /* the line scores tell the hands, they are all different */
+  int hand[LINES];
+  for (int l=0;l<LINES;l++) {
+    t->line[l] += r->score[l];
+    hand[l] = hand_of[l>=COLS+ROWS][r->score[l]];
+    t->hands[hand[l]]++;
+  }
+
+  int c = log_card(r,0), x = r->cell[0]/ROWS, y = r->cell[0]%ROWS;
+  int cols = 0;
+  for (int l=0;l<COLS;l++) cols += r->score[l];
+  t->first[c]++;
+  t->first_total[c] += r->total;
+  t->first_col[c] += r->score[x];
+  t->first_row[c] += r->score[COLS+y];
+  t->other_col[c] += (double)(cols-r->score[x])/(COLS-1);
+
+  /* a line is complete with the last of its cells */
+  int done[LINES] = { 0 };
+  for (int i=0;i<CELLS;i++)
+    for (const int *l=line_of[r->cell[i]];l<line_of[r->cell[i]]+4 && *l>=0;l++)
+      done[*l] = i;
+  for (int l=0;l<LINES;l++) t->steps[done[l]][hand[l]]++;
+}
+
+static void *work(void *arg) {
+  struct worker_t *w = arg;
+  for (const struct log_record_t *r=w->first;r<w->last;r++) tally(&w->t,r);
+  return NULL;
+}
+
+/* add all the counters of b to a */
+static void add(struct tally_t *a, const struct tally_t *b) {
+  a->games += b->games;
+  a->bad += b->bad;
+  for (int i=0;i<LOG_SOURCES;i++) a->sources[i] += b->sources[i];
+  a->total += b->total;
+  for (int l=0;l<LINES;l++) a->line[l] += b->line[l];
+  for (int h=0;h<HANDS;h++) a->hands[h] += b->hands[h];
+  for (int c=0;c<=CARDS;c++) {
+    a->first[c] += b->first[c];
+    a->first_total[c] += b->first_total[c];
+    a->first_col[c] += b->first_col[c];
+    a->first_row[c] += b->first_row[c];
+    a->other_col[c] += b->other_col[c];
+  }
+  for (int i=0;i<CELLS;i++)
+    for (int h=0;h<HANDS;h++) a->steps[i][h] += b->steps[i][h];
+}
+
+static void print_summary(const struct tally_t *t) {
+  printf("mean score   %.2f\n",t->total/t->games);
+  printf("\nmean score of the lines\n");
+  for (int l=0;l<LINES;l++) {
+    if (l<COLS)
+      printf("  column %d   ",l+1);
+    else if (l<COLS+ROWS)
+      printf("  row %d      ",l-COLS+1);
+    else
+      printf("  diagonal %d ",l-COLS-ROWS+1);
+    printf(" %6.2f\n",t->line[l]/t->games);
+  }
+  printf("\nhand types of all lines\n");
+  for (int h=0;h<HANDS;h++)
+    printf("  %-14s  %10ld  %6.2f%%\n",hand_name[h],t->hands[h],
+	   100.0*t->hands[h]/((double)t->games*LINES));
+}
+
+static void print_first(const struct tally_t *t) {
+  printf("first card      games    score   column      row  other columns\n");
+  for (int c=1;c<=CARDS;c++) {
+    long n = t->first[c];
+    if (n==0) continue;
+    printf("  %2d       %10ld  %7.2f  %7.2f  %7.2f  %7.2f\n",c,n,
+	   t->first_total[c]/n,t->first_col[c]/n,t->first_row[c]/n,
+	   t->other_col[c]/n);
+  }
+}
+
+static void print_steps(const struct tally_t *t) {
+  printf("completed lines by move, %% of the hand types\n\nmove        lines");
+  for (int h=1;h<HANDS;h++) printf(" %5.5s",hand_name[h]);
+  printf("\n");
+  for (int i=0;i<CELLS;i++) {
+    long n = 0;
+    for (int h=0;h<HANDS;h++) n += t->steps[i][h];
+    if (n==0) continue;
+    printf("  %2d   %10ld",i+1,n);
+    for (int h=1;h<HANDS;h++) printf(" %5.2f",100.0*t->steps[i][h]/n);
+    printf("\n");
+  }
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static void usage() {
+  fprintf(stderr,"usage: mathlog [-t threads] [-s source] [-q summary|first|steps] log\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  const char *query = "summary";
+  int c;
+
+  while ((c = getopt(argc,argv,"t:s:q:"))!=-1) {
+    switch (c) {
+    case 't': threads = atol(optarg); break;
+    case 's':
+      for (only=0;only<LOG_SOURCES && strcmp(optarg,log_source[only])!=0;only++)
+	;
+      if (only==LOG_SOURCES) usage();
+      break;
+    case 'q': query = optarg; break;
+    default: usage();
+    }
+  }
+  if (threads<1 || argc-optind!=1) usage();
+
+  void (*print)(const struct tally_t *);
+  if (strcmp(query,"summary")==0)
+    print = print_summary;
+  else if (strcmp(query,"first")==0)
+    print = print_first;
+  else if (strcmp(query,"steps")==0)
+    print = print_steps;
+  else
+    usage();
+
+  const char *path = argv[optind];
+  int fd = open(path,O_RDONLY);
+  struct stat st;
+  if (fd<0 || fstat(fd,&st)<0) {
+    perror(path);
+    return 1;
+  }
+  size_t size = (size_t)st.st_size;
+  void *map = size ? mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0) : NULL;
+  if (size && map==MAP_FAILED) {
+    perror(path);
+    return 1;
+  }
+  close(fd);
+
+  const char *error = "empty file";
+  long records = map ? log_check(map,size,&error) : -1;
+  if (records<0) {
+    fprintf(stderr,"mathlog: %s: %s\n",path,error);
+    return 1;
+  }
+  posix_madvise(map,size,POSIX_MADV_SEQUENTIAL);
+  const struct log_record_t *record =
+    (const struct log_record_t *)((const char *)map+sizeof(struct log_header_t));
+
+  init_tables();
+  if (threads>records) threads = records>0 ? records : 1;
+  struct worker_t *w = calloc((size_t)threads,sizeof(*w));
+  if (w==NULL) {
+    perror("mathlog");
+    return 1;
+  }
+
+  double start = now();
+  for (long t=0;t<threads;t++) {
+    w[t].first = record+records*t/threads;
+    w[t].last = record+records*(t+1)/threads;
+    if (pthread_create(&w[t].thread,NULL,work,&w[t])!=0) {
+      perror("mathlog");
+      return 1;
+    }
+  }
+  for (long t=0;t<threads;t++) {
+    pthread_join(w[t].thread,NULL);
+    if (t>0) add(&w[0].t,&w[t].t);
+  }
+  double seconds = now()-start;
+
+  printf("records      %ld\n",records);
+  for (int s=0;s<LOG_SOURCES;s++)
+    if (w[0].t.sources[s]) printf("  %-10s %ld\n",log_source[s],w[0].t.sources[s]);
+  printf("threads      %ld\n",threads);
+  printf("seconds      %.3f\n",seconds);
+  printf("records/s    %.0f\n",seconds>0 ? records/seconds : 0.0);
+  printf("games        %ld\n",w[0].t.games);
+  if (w[0].t.bad>0) printf("bad records  %ld, not counted\n",w[0].t.bad);
+  printf("\n");
+  if (w[0].t.games>0) print(&w[0].t);
+
+  munmap(map,size);
+  free(w);
+  return 0;
+}
@@ -0,0 +1,211 @@
+
+/*********************************************************************
+ *
+ * mathsim - play many games of mathematico on all cores
+ *
+ * Usage: mathsim [-n games] [-t threads] [-s seed] [-b bin]
+ *                [-p random|greedy|heuristic] [-H heuristic.so] [-l log]
+ *
+ * Game i is seeded from the seed and i alone, so the results don't
+ * depend on the number of threads. -l appends every game to a log, see
+ * gamelog.h; the games of a thread are written in batches, so the order
+ * in the log is not the order of i.
+ *
+ * A heuristic is a shared object with the function
+ *
+ *   int heuristic(struct game_t *g, int x, int y);
+ *
+ * that rates placing g->card on the empty cell (x,y), see policy.h.
+ * Build it with "cc -std=c99 -shared -fPIC -o h.so h.c"; it may call
+ * the engine functions of mathsim.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "gamelog.h"
+#include "policy.h"
+
+#define MAX_SCORE	((COLS+ROWS)*200+2*210)
+#define LOG_BATCH	1024		/* records written at once */
+
+struct worker_t {
+  pthread_t thread;
+  long first, last;		/* games first..last-1 */
+  long hist[MAX_SCORE+1];	/* final scores */
+  long hands[HANDS];		/* hand types of all lines at the end */
+  double sum;
+};
+
+static uint64_t seed = 1;
+static rating_t rate;
+static int source;		/* of the games in the log */
+static int log_fd = -1;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void flush_log(struct log_record_t *r, int n) {
+  pthread_mutex_lock(&log_lock);
+  if (log_write(log_fd,r,n)<0) {
+    perror("mathsim: log");
+    exit(1);
+  }
+  pthread_mutex_unlock(&log_lock);
+}
+
+static uint64_t mix(uint64_t z) {
+  z = (z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+  z = (z^(z>>27))*0x94D049BB133111EBULL;
+  return z^(z>>31);
+}
+
+static void *work(void *arg) {
+  struct worker_t *w = arg;
+  struct game_t g;
+  struct log_record_t *batch = NULL;
+  int logged = 0;
+
+  if (log_fd>=0 && (batch = malloc(LOG_BATCH*sizeof(*batch)))==NULL) {
+    perror("mathsim");
+    exit(1);
+  }
+
+  for (long i=w->first;i<w->last;i++) {
+    game_init(&g,mix(seed^mix((uint64_t)i)));
+    play_out(&g,rate);
+
+    if (batch) {
+      log_fill(&batch[logged++],&g,source);
+      if (logged==LOG_BATCH) {
+	flush_log(batch,logged);
+	logged = 0;
+      }
+    }
+
+    w->hist[game_total(&g)]++;
+    w->sum += game_total(&g);
+    for (int l=0;l<LINES;l++)
+      w->hands[line_hand((const int (*)[ROWS])g.board,l)]++;
+  }
+  if (logged>0) flush_log(batch,logged);
+  free(batch);
+  return NULL;
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static void usage() {
+  fprintf(stderr,"usage: mathsim [-n games] [-t threads] [-s seed] [-b bin]\n"
+	  "               [-p random|greedy|heuristic] [-H heuristic.so] [-l log]\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  long games = 1000000;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int bin = 50;
+  const char *policy = "greedy";
+  const char *library = NULL;
+  const char *log_path = NULL;
+  int c;
+
+  while ((c = getopt(argc,argv,"n:t:s:b:p:H:l:"))!=-1) {
+    switch (c) {
+    case 'n': games = atol(optarg); break;
+    case 't': threads = atol(optarg); break;
+    case 's': seed = strtoull(optarg,NULL,0); break;
+    case 'b': bin = atoi(optarg); break;
+    case 'p': policy = optarg; break;
+    case 'H': library = optarg; policy = "heuristic"; break;
+    case 'l': log_path = optarg; break;
+    default: usage();
+    }
+  }
+  if (games<1 || threads<1 || bin<1 || optind<argc) usage();
+
+  if (strcmp(policy,"random")==0) {
+    rate = NULL;
+    source = LOG_RANDOM;
+  } else if (strcmp(policy,"greedy")==0) {
+    rate = rate_gain;
+    source = LOG_GREEDY;
+  } else if (strcmp(policy,"heuristic")==0) {
+    source = LOG_HEURISTIC;
+    if (library==NULL) usage();
+    void *so = dlopen(library,RTLD_NOW);
+    if (so==NULL) {
+      fprintf(stderr,"mathsim: %s\n",dlerror());
+      return 1;
+    }
+    *(void **)&rate = dlsym(so,"heuristic");
+    if (rate==NULL) {
+      fprintf(stderr,"mathsim: %s\n",dlerror());
+      return 1;
+    }
+  } else {
+    usage();
+  }
+
+  if (log_path && (log_fd = log_open(log_path))<0) {
+    perror(log_path);
+    return 1;
+  }
+
+  struct worker_t *w = calloc((size_t)threads,sizeof(*w));
+  if (w==NULL) {
+    perror("mathsim");
+    return 1;
+  }
+
+  double start = now();
+  for (long t=0;t<threads;t++) {
+    w[t].first = games*t/threads;
+    w[t].last = games*(t+1)/threads;
+    if (pthread_create(&w[t].thread,NULL,work,&w[t])!=0) {
+      perror("mathsim");
+      return 1;
+    }
+  }
+  for (long t=0;t<threads;t++) {
+    pthread_join(w[t].thread,NULL);
+    if (t>0) {
+      for (int s=0;s<=MAX_SCORE;s++) w[0].hist[s] += w[t].hist[s];
+      for (int h=0;h<HANDS;h++) w[0].hands[h] += w[t].hands[h];
+      w[0].sum += w[t].sum;
+    }
+  }
+  double seconds = now()-start;
+  if (log_fd>=0) close(log_fd);
+
+  printf("games        %ld\n",games);
+  printf("threads      %ld\n",threads);
+  printf("policy       %s\n",policy);
+  printf("seconds      %.3f\n",seconds);
+  printf("games/s      %.0f\n",games/seconds);
+  printf("mean score   %.2f\n",w[0].sum/games);
+
+  printf("\nscore histogram\n");
+  for (int lo=0;lo<=MAX_SCORE;lo+=bin) {
+    long n = 0;
+    for (int s=lo;s<lo+bin && s<=MAX_SCORE;s++) n += w[0].hist[s];
+    if (n>0)
+      printf("  %4d-%-4d  %10ld  %6.2f%%\n",lo,lo+bin-1,n,100.0*n/games);
+  }
+
+  printf("\nhand types of all lines\n");
+  for (int h=0;h<HANDS;h++)
+    printf("  %-14s  %10ld  %6.2f%%\n",hand_name[h],w[0].hands[h],
+	   100.0*w[0].hands[h]/(games*LINES));
+
+  free(w);
+  return 0;
+}
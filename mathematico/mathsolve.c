@@ -0,0 +1,365 @@
+
+/*********************************************************************
+ *
+ * mathsolve - exact endgame of mathematico
+ *
+ * Usage: mathsolve [-m megabytes] [file]
+ *
+ * Reads a board as ROWS lines of COLS numbers, 0 for an empty cell,
+ * optionally followed by the current card. The cards not on the board
+ * (and not the current card) are the deck. Prints the expected final
+ * score of every empty cell for the current card, or of every card and
+ * its best cell, if there is no current card.
+ *
+ * The search is an expectimax over the deck. Its value only depends on
+ * the board: the deck is whatever is not on it. Only the cells that are
+ * empty at the start change, so the transposition table key is their
+ * cards, packed into 4 bits per cell.
+ *
+ * Lines without an empty cell keep their score to the end, so the table
+ * holds the expected score still to come from the other lines, and the
+ * key can forget what only full lines see: two cards swapped between
+ * cells that are in the same lines with empty cells leave the rest of
+ * the game as it is. The key has the cards of every such group of
+ * cells sorted. This holds for any board and merges more positions the
+ * deeper the search gets.
+ *
+ * The score is also the same for all 8 rotations and reflections of the
+ * board. Those that map the board of the start onto itself also map
+ * every board of the search onto another one, and the key is the
+ * smallest of them.
+ *
+ * The search still grows with about 13^K for K empty cells: on one core
+ * five take 0.15 s, six 2 s and seven 20 s, more is out of reach.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "engine.h"
+
+#define CELLS	(COLS*ROWS)
+
+struct entry_t {
+  uint64_t lo, hi;		/* canonical board, bit 63 of hi marks a used entry */
+  double value;			/* expected score still to come from open lines */
+};
+
+static struct entry_t *table;
+static uint64_t table_mask;
+static long used, probes, hits, nodes;
+
+static int deck[CARDS+1];	/* cards left per value */
+static int ndeck;
+
+static int nfree;		/* cells empty at the start */
+static int free_x[CELLS], free_y[CELLS];
+static uint32_t free_lines[CELLS];	/* bit l for each line l through the cell */
+static int nsym;		/* symmetries of the start */
+static int sym[8][CELLS];	/* free cell k goes to free cell sym[t][k] */
+
+/* find the transformations that keep the board of the start */
+static void init_symmetries(const struct game_t *g) {
+  for (int x=0;x<COLS;x++) {
+    for (int y=0;y<ROWS;y++) {
+      if (g->board[x][y]==0) {
+	free_x[nfree] = x;
+	free_y[nfree] = y;
+	free_lines[nfree] = 1u<<x | 1u<<(COLS+y);
+	if (x==y) free_lines[nfree] |= 1u<<(COLS+ROWS);
+	if (x==ROWS-1-y) free_lines[nfree] |= 1u<<(COLS+ROWS+1);
+	nfree++;
+      }
+    }
+  }
+
+  for (int t=0;t<8;t++) {
+    int map[COLS][ROWS][2];
+    bool same = true;
+
+    for (int x=0;x<COLS;x++) {
+      for (int y=0;y<ROWS;y++) {
+	int u = t&1 ? COLS-1-x : x;	/* mirror */
+	int v = t&2 ? ROWS-1-y : y;	/* flip */
+	if (t&4) {			/* transpose */
+	  int w = u;
+	  u = v;
+	  v = w;
+	}
+	map[x][y][0] = u;
+	map[x][y][1] = v;
+	same &= g->board[u][v]==g->board[x][y];
+      }
+    }
+    if (!same) continue;
+
+    for (int k=0;k<nfree;k++) {
+      int j = 0;
+      while (free_x[j]!=map[free_x[k]][free_y[k]][0]
+	     || free_y[j]!=map[free_x[k]][free_y[k]][1]) j++;
+      sym[nsym][k] = j;
+    }
+    nsym++;
+  }
+}
+
+/* the key of the board: the smallest of the transformed cards on the
+   free cells, sorted within the cells of the same open lines. Returns
+   the score of the full lines, which the key leaves out. */
+static int canonical(const struct game_t *g, uint64_t *lo, uint64_t *hi) {
+  int card[CELLS];
+  uint32_t open = 0, group[CELLS];
+  int full = 0;
+
+  for (int k=0;k<nfree;k++) {
+    card[k] = g->board[free_x[k]][free_y[k]];
+    if (card[k]==0) open |= free_lines[k];
+  }
+  for (int l=0;l<LINES;l++)
+    if (!(open>>l&1)) full += g->score[l];
+
+  /* selection sort within groups, the empty cells stay where they are */
+  for (int k=0;k<nfree;k++) group[k] = free_lines[k]&open;
+  for (int k=0;k<nfree;k++) {
+    if (card[k]==0) continue;
+    for (int j=k+1;j<nfree;j++) {
+      if (group[j]==group[k] && card[j]!=0 && card[j]<card[k]) {
+	int c = card[j];
+	card[j] = card[k];
+	card[k] = c;
+      }
+    }
+  }
+
+  *lo = *hi = UINT64_MAX;
+  for (int t=0;t<nsym;t++) {
+    uint64_t l = 0, h = 0;
+    for (int k=0;k<nfree;k++) {
+      uint64_t c = (uint64_t)card[k];
+      int j = sym[t][k];
+      if (j<16)
+	l |= c<<(4*j);
+      else
+	h |= c<<(4*(j-16));
+    }
+    if (h<*hi || (h==*hi && l<*lo)) {
+      *lo = l;
+      *hi = h;
+    }
+  }
+  *hi |= 1ULL<<63;
+  return full;
+}
+
+static uint64_t mix(uint64_t z) {
+  z = (z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+  z = (z^(z>>27))*0x94D049BB133111EBULL;
+  return z^(z>>31);
+}
+
+/* the entry of a board, or the one to put it in */
+static struct entry_t *slot(uint64_t lo, uint64_t hi) {
+  uint64_t i = mix(lo^mix(hi));
+  for (int n=0;n<4;n++) {
+    struct entry_t *e = &table[(i+n)&table_mask];
+    if ((e->hi==hi && e->lo==lo) || e->hi==0) return e;
+  }
+  return &table[i&table_mask];	/* replace */
+}
+
+/* look a board up, counted for the statistics */
+static struct entry_t *probe(uint64_t lo, uint64_t hi) {
+  struct entry_t *e = slot(lo,hi);
+  probes++;
+  if (e->hi==hi && e->lo==lo) hits++;
+  return e;
+}
+
+static void store(uint64_t lo, uint64_t hi, double value) {
+  struct entry_t *e = slot(lo,hi);
+  if (e->hi==0) used++;
+  e->lo = lo;
+  e->hi = hi;
+  e->value = value;
+}
+
+/* expected final score with 'empty' empty cells, before the next card */
+static double expect(struct game_t *g, int empty) {
+  nodes++;
+  if (empty==0) return game_total(g);
+
+  /* the last cell needs no choice and is not worth a table entry */
+  if (empty==1) {
+    int k = 0;
+    while (g->board[free_x[k]][free_y[k]]!=0) k++;
+    double sum = 0;
+    for (int c=1;c<=CARDS;c++)
+      sum += deck[c]*game_gain(g,free_x[k],free_y[k],c);
+    return game_total(g)+sum/ndeck;
+  }
+
+  uint64_t lo, hi;
+  int full = canonical(g,&lo,&hi);
+  struct entry_t *e = probe(lo,hi);
+  if (e->hi==hi && e->lo==lo) return full+e->value;
+
+  double sum = 0;
+  for (int c=1;c<=CARDS;c++) {
+    if (deck[c]==0) continue;
+    int n = deck[c];
+    double best = -1;
+    deck[c]--;
+    ndeck--;
+    for (int k=0;k<nfree;k++) {
+      int x = free_x[k], y = free_y[k];
+      if (g->board[x][y]!=0) continue;
+      game_place(g,x,y,c);
+      double v = expect(g,empty-1);
+      game_unplace(g,x,y);
+      if (v>best) best = v;
+    }
+    deck[c]++;
+    ndeck++;
+    sum += n*best;
+  }
+
+  /* not in e, the recursion may have reused that entry */
+  store(lo,hi,sum/ndeck-full);
+  return sum/ndeck;
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static void usage() {
+  fprintf(stderr,"usage: mathsolve [-m megabytes] [file]\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  long megabytes = 64;
+  struct game_t g;
+  int c;
+
+  while ((c = getopt(argc,argv,"m:"))!=-1) {
+    switch (c) {
+    case 'm': megabytes = atol(optarg); break;
+    default: usage();
+    }
+  }
+  if (megabytes<1 || argc-optind>1) usage();
+
+  FILE *in = stdin;
+  if (optind<argc && (in = fopen(argv[optind],"r"))==NULL) {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  /* board as rows, g.board[x][y] is column x, row y */
+  game_init(&g,0);
+  for (int i=0;i<COLS*ROWS;i++) {
+    int x = i%COLS, y = i/COLS;
+    if (fscanf(in,"%d",&g.board[x][y])!=1 || g.board[x][y]<0 || g.board[x][y]>CARDS) {
+      fprintf(stderr,"mathsolve: expected %d numbers in 0..%d\n",COLS*ROWS,CARDS);
+      return 1;
+    }
+  }
+  if (fscanf(in,"%d",&g.card)!=1) g.card = 0;
+  if (g.card<0 || g.card>CARDS) {
+    fprintf(stderr,"mathsolve: no card %d\n",g.card);
+    return 1;
+  }
+  game_rescan(&g);
+
+  for (int v=1;v<=CARDS;v++) deck[v] = COPIES;
+  for (int x=0;x<COLS;x++)
+    for (int y=0;y<ROWS;y++)
+      deck[g.board[x][y]]--;
+  deck[g.card]--;
+  deck[0] = 0;
+  for (int v=1;v<=CARDS;v++) {
+    if (deck[v]<0) {
+      fprintf(stderr,"mathsolve: more than %d cards of %d\n",COPIES,v);
+      return 1;
+    }
+    ndeck += deck[v];
+  }
+  int empty = ROWS*COLS-g.filled;
+  if (empty>31) {			/* bit 63 of the key is the mark */
+    fprintf(stderr,"mathsolve: at most 31 empty cells\n");
+    return 1;
+  }
+
+  /* largest power of two of entries that fits */
+  uint64_t entries = 1;
+  while (entries*2*sizeof(struct entry_t)<=(uint64_t)megabytes<<20) entries *= 2;
+  table = calloc(entries,sizeof(struct entry_t));
+  if (table==NULL) {
+    perror("mathsolve");
+    return 1;
+  }
+  table_mask = entries-1;
+
+  /* with a current card, the search starts after placing it */
+  init_symmetries(&g);
+
+  double start = now();
+  if (empty==0) {
+    printf("final score %d\n",game_total(&g));
+  } else if (g.card!=0) {
+    printf("expected final score for card %d\n",g.card);
+    for (int y=0;y<ROWS;y++) {
+      for (int x=0;x<COLS;x++) {
+	if (g.board[x][y]!=0) {
+	  printf("     .  ");
+	  continue;
+	}
+	game_place(&g,x,y,g.card);
+	printf("%8.2f",expect(&g,empty-1));
+	game_unplace(&g,x,y);
+      }
+      printf("\n");
+    }
+  } else {
+    printf("expected final score %.2f\n",expect(&g,empty));
+    for (int v=1;v<=CARDS;v++) {
+      if (deck[v]==0) continue;
+      int bx = 0, by = 0;
+      double best = -1;
+      deck[v]--;
+      ndeck--;
+      for (int i=0;i<COLS*ROWS;i++) {
+	int x = i/ROWS, y = i%ROWS;
+	if (g.board[x][y]!=0) continue;
+	game_place(&g,x,y,v);
+	double e = expect(&g,empty-1);
+	game_unplace(&g,x,y);
+	if (e>best) {
+	  best = e;
+	  bx = x;
+	  by = y;
+	}
+      }
+      deck[v]++;
+      ndeck++;
+      printf("  card %2d  column %d row %d  %8.2f\n",v,bx+1,by+1,best);
+    }
+  }
+  double seconds = now()-start;
+
+  fprintf(stderr,"nodes %ld in %.3f s, %.0f nodes/s\n",nodes,seconds,
+	  seconds>0 ? nodes/seconds : 0.0);
+  fprintf(stderr,"table hits %ld of %ld probes (%.1f%%)\n",hits,probes,
+	  probes ? 100.0*hits/probes : 0.0);
+  fprintf(stderr,"table %ld of %llu entries used, %.1f of %.1f MB\n",used,
+	  (unsigned long long)entries,
+	  used*sizeof(struct entry_t)/1048576.0,
+	  entries*sizeof(struct entry_t)/1048576.0);
+  return 0;
+}
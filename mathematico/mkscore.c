@@ -0,0 +1,347 @@
+
+/*********************************************************************
+ *
+ * mkscore - generate the scoring table of mathematico
+ *
+ * Every possible line is evaluated with the original rules and its
+ * rank histogram (see score.h) is placed into a perfect hash built by
+ * hash and displace: the histograms are spread over buckets, and each
+ * bucket gets a displacement that moves its histograms into free
+ * slots. Two histograms may share a slot, if they are the same hand.
+ * The table is made as small as the lines of SIZE cells allow.
+ *
+ * A line of more than five cells scores its best five cards, one of
+ * four scores like five with an empty cell.
+ *
+ * Usage: mkscore score_tab.h > score_tab.c
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#define MKSCORE
+#include "score.h"
+#include "reference.h"
+
+#define N	SIZE		/* cells of a line */
+
+static const struct {
+  int score;
+  const char *name;
+} hands[HANDS] = {
+  {   0, "nothing" },
+  {  10, "one pair" },
+  {  20, "two pairs" },
+  {  40, "three in a row" },
+  {  50, "street" },
+  {  80, "full house" },
+  { 100, "1 1 1 13 13" },
+  { 150, "1 10 11 12 13" },
+  { 160, "four in a row" },
+  { 200, "1 1 1 1" }
+};
+
+static int hand_of_score(int score) {
+  for (int h=0;h<HANDS;h++)
+    if (hands[h].score==score) return h;
+  fprintf(stderr,"mkscore: no hand type for score %d\n",score);
+  exit(1);
+}
+
+/* score of a line of N cells, sorted or not */
+static int eval_line(const int *x) {
+  static int subset[32][5];	/* the ways to choose five of N cells */
+  static int nsubsets;
+  int c[5] = { 0, 0, 0, 0, 0 };
+
+  if (N<=5) {
+    for (int i=0;i<N;i++) c[i] = x[i];
+    return eval_five(c[0],c[1],c[2],c[3],c[4]);
+  }
+
+  if (nsubsets==0) {
+    for (int m=0;m<1<<N;m++) {
+      if (__builtin_popcount((unsigned)m)!=5) continue;
+      int n = 0;
+      for (int i=0;i<N;i++)
+	if (m&1<<i) subset[nsubsets][n++] = i;
+      nsubsets++;
+    }
+  }
+
+  /* the best five */
+  int best = 0;
+  for (int k=0;k<nsubsets;k++) {
+    const int *i = subset[k];
+    int s = eval_five(x[i[0]],x[i[1]],x[i[2]],x[i[3]],x[i[4]]);
+    if (s>best) best = s;
+  }
+  return best;
+}
+
+static uint64_t bit_of(int rank) {
+  return rank ? 1ULL<<(3*(rank-1)) : 0;
+}
+
+static uint64_t *key;
+static int *hand;
+static int nkeys;
+
+/* visit all lines with sorted cells */
+static void each_line(int pos, int min, int *x) {
+  if (pos==N) {
+    if (key) {
+      key[nkeys] = 0;
+      for (int i=0;i<N;i++) key[nkeys] += bit_of(x[i]);
+      hand[nkeys] = hand_of_score(eval_line(x));
+    }
+    nkeys++;
+    return;
+  }
+  for (int r=min;r<RANKS;r++) {
+    x[pos]=r;
+    each_line(pos+1,r,x);
+  }
+}
+
+/* the hash */
+static int bucket_bits, slot_bits;
+static int *disp, *slot;
+
+static int bucket_of(uint64_t h) {
+  return (int)((h*SCORE_K1)>>(64-bucket_bits));
+}
+
+static int slot_of(uint64_t h) {
+  return (int)((h*SCORE_K2)>>(64-slot_bits));
+}
+
+static int lookup(uint64_t h) {
+  return slot[slot_of(h)^disp[bucket_of(h)]];
+}
+
+/* try to build the hash with 2^bits slots and an eighth as many buckets */
+static bool build(int bits) {
+  slot_bits = bits;
+  bucket_bits = bits-3;
+  int buckets = 1<<bucket_bits, slots = 1<<slot_bits;
+  int *first = calloc((size_t)buckets+1,sizeof(int));	/* keys of bucket b: order[first[b]..first[b+1]-1] */
+  int *fill = malloc((size_t)buckets*sizeof(int));
+  int *order = malloc((size_t)nkeys*sizeof(int));
+  int *bysize = malloc((size_t)buckets*sizeof(int));
+  free(disp);
+  free(slot);
+  disp = malloc((size_t)buckets*sizeof(int));
+  slot = malloc((size_t)slots*sizeof(int));
+  if (!first || !fill || !order || !bysize || !disp || !slot) {
+    perror("mkscore");
+    exit(1);
+  }
+
+  /* sort keys into buckets */
+  for (int k=0;k<nkeys;k++) first[bucket_of(key[k])+1]++;
+  for (int b=0;b<buckets;b++) first[b+1]+=first[b];
+  for (int b=0;b<buckets;b++) fill[b]=first[b];
+  for (int k=0;k<nkeys;k++) order[fill[bucket_of(key[k])]++]=k;
+
+  /* place the big buckets first */
+  for (int b=0;b<buckets;b++) bysize[b]=b;
+  for (int i=1;i<buckets;i++) {
+    int b=bysize[i], n=first[b+1]-first[b], j=i;
+    while (j>0 && first[bysize[j-1]+1]-first[bysize[j-1]]<n) {
+      bysize[j]=bysize[j-1];
+      j--;
+    }
+    bysize[j]=b;
+  }
+
+  bool ok = true;
+  for (int i=0;i<slots;i++) slot[i]=-1;
+  for (int i=0;i<buckets && ok;i++) {
+    int b=bysize[i], d;
+    for (d=0;d<slots;d++) {
+      int k;
+      for (k=first[b];k<first[b+1];k++) {
+	int s=slot_of(key[order[k]])^d;
+	if (slot[s]!=-1 && slot[s]!=hand[order[k]]) break;
+	/* the bucket must agree with itself, too */
+	int j;
+	for (j=first[b];j<k;j++)
+	  if ((slot_of(key[order[j]])^d)==s && hand[order[j]]!=hand[order[k]]) break;
+	if (j<k) break;
+      }
+      if (k==first[b+1]) break;
+    }
+    if (d==slots) {
+      ok = false;
+      break;
+    }
+    disp[b]=d;
+    for (int k=first[b];k<first[b+1];k++)
+      slot[slot_of(key[order[k]])^d]=hand[order[k]];
+  }
+
+  free(first);
+  free(fill);
+  free(order);
+  free(bysize);
+  return ok;
+}
+
+/* print the sum of score_bit[] over the cells of line l */
+static void print_hist(FILE *f, int l) {
+  for (int i=0;i<N;i++) {
+    int x, y;
+    if (l<COLS) {
+      x = l; y = i;
+    } else if (l<COLS+ROWS) {
+      x = i; y = l-COLS;
+    } else if (l==COLS+ROWS) {
+      x = i; y = i;
+    } else {
+      x = N-1-i; y = i;
+    }
+    fprintf(f,"%sscore_bit[board[%d][%d]]",i?"+":"",x,y);
+  }
+}
+
+static void write_header(FILE *f) {
+  fprintf(f,"/* generated by mkscore for %dx%d boards, do not edit */\n\n",N,N);
+  fprintf(f,"#if SIZE != %d\n"
+	  "#error \"score_tab.h was generated for %dx%d boards, make clean first\"\n"
+	  "#endif\n\n",N,N,N);
+  fprintf(f,"#define SCORE_BUCKET_BITS\t%d\n",bucket_bits);
+  fprintf(f,"#define SCORE_SLOT_BITS\t\t%d\n\n",slot_bits);
+  fprintf(f,"extern const %s score_disp[1<<SCORE_BUCKET_BITS];\n",
+	  slot_bits>16?"unsigned int":"unsigned short");
+  fprintf(f,"extern const unsigned char score_hand[1<<SCORE_SLOT_BITS];\n\n");
+
+  fprintf(f,"static inline int hand_of_hist(uint64_t h) {\n"
+	  "  return score_hand[((h*SCORE_K2)>>(64-SCORE_SLOT_BITS))\n"
+	  "\t\t    ^ score_disp[(h*SCORE_K1)>>(64-SCORE_BUCKET_BITS)]];\n"
+	  "}\n\n");
+
+  fprintf(f,"/* rank histogram of line i of a board, see LINES for the order */\n"
+	  "static inline uint64_t line_hist(const int board[COLS][ROWS], int i) {\n"
+	  "  switch (i) {\n");
+  for (int l=0;l<LINES;l++) {
+    fprintf(f,l<LINES-1 ? "  case %d:\n" : "  default:\n",l);
+    fprintf(f,"    return ");
+    print_hist(f,l);
+    fprintf(f,";\n");
+  }
+  fprintf(f,"  }\n}\n\n");
+
+  fprintf(f,"/* score all lines of a board, returns the total */\n"
+	  "static inline int score_board(const int board[COLS][ROWS], int score[LINES]) {\n");
+  for (int l=0;l<LINES;l++) {
+    fprintf(f,"  score[%d] = %s[hand_of_hist(",l,l<COLS+ROWS?"hand_score":"hand_diag_score");
+    print_hist(f,l);
+    fprintf(f,")];\n");
+  }
+  fprintf(f,"  return ");
+  for (int l=0;l<LINES;l++) fprintf(f,"%sscore[%d]",l?"+":"",l);
+  fprintf(f,";\n}\n");
+}
+
+int main(int argc, char **argv) {
+  int x[N];
+
+  if (argc!=2) {
+    fprintf(stderr,"usage: mkscore score_tab.h > score_tab.c\n");
+    return 1;
+  }
+
+  /* count, then collect the lines */
+  each_line(0,0,x);
+  key = malloc((size_t)nkeys*sizeof(*key));
+  hand = malloc((size_t)nkeys*sizeof(*hand));
+  if (!key || !hand) {
+    perror("mkscore");
+    return 1;
+  }
+  nkeys = 0;
+  each_line(0,0,x);
+
+  /* the smallest table that works */
+  int bits;
+  for (bits=8;bits<=24 && !build(bits);bits++)
+    ;
+  if (bits>24) {
+    fprintf(stderr,"mkscore: no perfect hash, change SCORE_K1/K2\n");
+    return 1;
+  }
+
+  /* check the hash against the rules: every line in every order, up
+     to six cells, every sorted line for seven */
+  long lines = 1;
+  for (int i=0;i<N;i++) lines *= RANKS;
+  if (N>6) lines = 0;
+  for (long i=0;i<lines;i++) {
+    long n=i;
+    uint64_t h=0;
+    for (int j=0;j<N;j++) {
+      x[j]=(int)(n%RANKS);
+      n/=RANKS;
+      h+=bit_of(x[j]);
+    }
+    if (hands[lookup(h)].score!=eval_line(x)) {
+      fprintf(stderr,"mkscore: wrong score for line %ld\n",i);
+      return 1;
+    }
+  }
+  for (int k=0;k<nkeys;k++) {
+    if (lookup(key[k])!=hand[k]) {
+      fprintf(stderr,"mkscore: wrong hand for histogram %llx\n",
+	      (unsigned long long)key[k]);
+      return 1;
+    }
+  }
+
+  FILE *f = fopen(argv[1],"w");
+  if (f==NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+  write_header(f);
+  if (fclose(f)!=0) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  printf("/* generated by mkscore for %dx%d boards, do not edit */\n\n",N,N);
+  printf("#include \"score.h\"\n\n");
+
+  printf("const uint64_t score_bit[RANKS] = {\n");
+  for (int r=0;r<RANKS;r++)
+    printf("  0x%011llxULL,\t/* %d */\n",(unsigned long long)bit_of(r),r);
+  printf("};\n\n");
+
+  printf("const %s score_disp[1<<SCORE_BUCKET_BITS] = {",
+	 slot_bits>16?"unsigned int":"unsigned short");
+  for (int b=0;b<1<<bucket_bits;b++)
+    printf("%s%4d,",b%12?"":"\n ",disp[b]);
+  printf("\n};\n\n");
+
+  /* unused slots are never looked up, make them "nothing" */
+  printf("const unsigned char score_hand[1<<SCORE_SLOT_BITS] = {");
+  for (int s=0;s<1<<slot_bits;s++)
+    printf("%s%d,",s%32?"":"\n ",slot[s]<0?0:slot[s]);
+  printf("\n};\n\n");
+
+  printf("const int hand_score[HANDS] = {");
+  for (int h=0;h<HANDS;h++) printf("%s%d",h?",":"",hands[h].score);
+  printf("};\n\n");
+
+  /* diagonals earn 10 extra points, if they score at all */
+  printf("const int hand_diag_score[HANDS] = {");
+  for (int h=0;h<HANDS;h++)
+    printf("%s%d",h?",":"",hands[h].score>0?hands[h].score+10:0);
+  printf("};\n\n");
+
+  printf("const char *hand_name[HANDS] = {\n");
+  for (int h=0;h<HANDS;h++) printf("  \"%s\",\n",hands[h].name);
+  printf("};\n");
+
+  return 0;
+}
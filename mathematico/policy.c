@@ -0,0 +1,42 @@
+
+/*********************************************************************
+ *
+ * policy.c - placement policies for mathematico
+ */
+
+#include "policy.h"
+
+int rate_gain(struct game_t *g, int x, int y) {
+  return game_gain(g,x,y,g->card);
+}
+
+void choose_cell(struct game_t *g, rating_t rate, int *x, int *y) {
+  int best = 0, ties = 0;
+
+  for (int i=0;i<COLS;i++) {
+    for (int j=0;j<ROWS;j++) {
+      if (g->board[i][j]!=0) continue;
+      int r = rate ? rate(g,i,j) : 0;
+      if (ties==0 || r>best) {
+	best = r;
+	ties = 0;
+      } else if (r<best) {
+	continue;
+      }
+      /* reservoir sampling among the best cells */
+      if (game_random(g,(uint32_t)++ties)==0) {
+	*x = i;
+	*y = j;
+      }
+    }
+  }
+}
+
+void play_out(struct game_t *g, rating_t rate) {
+  while (!game_finished(g)) {
+    int x, y;
+    game_deal(g);
+    choose_cell(g,rate,&x,&y);
+    game_place(g,x,y,g->card);
+  }
+}
@@ -0,0 +1,27 @@
+
+/*********************************************************************
+ *
+ * policy.h - placement policies for mathematico
+ *
+ * A policy rates placing the current card on an empty cell, higher is
+ * better. The rating may place and take back cards, but must leave
+ * the game as it found it. Ties are broken at random.
+ */
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "engine.h"
+
+typedef int (*rating_t)(struct game_t *g, int x, int y);
+
+/* immediate gain of total_score() */
+int rate_gain(struct game_t *g, int x, int y);
+
+/* choose an empty cell for g->card, at random if rate is NULL */
+void choose_cell(struct game_t *g, rating_t rate, int *x, int *y);
+
+/* deal and place cards until the board is full */
+void play_out(struct game_t *g, rating_t rate);
+
+#endif
@@ -0,0 +1,103 @@
+/*********************************************************************
+ *
+ * reference.h - the rules of mathematico as they were written first
+ *
+ * eval_five() is frozen: mkscore builds the scoring table from it and
+ * mathbench checks every faster scorer against it. Don't change it, not
+ * even to make it faster.
+ */
+
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include <stdbool.h>
+
+/* the rules, as they have been in mathematico.c since version 1.0 */
+static int eval_five(int a, int b, int c, int d, int e) {
+  int res = 0;
+  int x[5];
+
+  x[0]=a; x[1]=b; x[2]=c; x[3]=d; x[4]=e;
+
+  /* sort x[] */
+  for (int i=0;i<4;i++)
+    for (int j=i+1;j<5;j++)
+      if (x[i]>x[j]) {
+	int tmp=x[i];
+	x[i]=x[j];
+	x[j]=tmp;
+      }
+
+  /* fill zeros in x[] with numbers that don't gain score */
+  int value = 20;
+  for (int i=0;i<5;i++) {
+    if (x[i]==0) x[i]=value;
+    value+=2;
+  }
+
+  /* one pair */
+  if ((x[0]==x[1])||(x[1]==x[2])||(x[2]==x[3])||(x[3]==x[4]))
+    res=10;
+
+  /* two pairs */
+  if (((x[0]==x[1])&&((x[2]==x[3])||(x[3]==x[4])))
+      ||((x[1]==x[2])&&(x[3]==x[4])))
+    res=20;
+
+  /* 3x same */
+  if (((x[1]==x[2])&&((x[0]==x[1])||(x[2]==x[3])))
+      ||((x[2]==x[3])&&(x[3]==x[4])))
+    res=40;
+
+  /* full house */
+  if ((x[0]==x[1])&&(x[3]==x[4])&&((x[2]==x[1])||(x[2]==x[3])))
+    res=80;
+
+  /* full house out of 1 and 13 */
+  if ((x[0]==1)&&(x[1]==1)&&(x[2]==1)&&(x[3]==13)&&(x[4]==13))
+    res=100;
+
+  /* 4x same */
+  if ((x[1]==x[2])&&(x[2]==x[3])&&((x[0]==x[1])||(x[3]==x[4])))
+    res=160;
+
+  /* 4x one */
+  if ((x[0]==1)&&(x[1]==1)&&(x[2]==1)&&(x[3]==1))
+    res=200;
+
+  /* street */
+  if ((x[0]+1==x[1])&&(x[1]+1==x[2])&&(x[2]+1==x[3])&&(x[3]+1==x[4]))
+    res=50;
+
+  /* 1,10,11,12,13 */
+  if ((x[0]==1)&&(x[1]==10)&&(x[2]==11)&&(x[3]==12)&&(x[4]==13))
+    res=150;
+
+  return res;
+}
+
+/* eval_board() of mathematico 1.2.1 on a 5x5 board, true if it is full */
+static inline bool eval_board(const int board[5][5], int score[12]) {
+  for (int i=0;i<5;i++) {
+    score[i] = eval_five(board[i][0],board[i][1],board[i][2],board[i][3],board[i][4]);
+  }
+  for (int i=0;i<5;i++) {
+    score[5+i] = eval_five(board[0][i],board[1][i],board[2][i],board[3][i],board[4][i]);
+  }
+
+  int diag_score;
+  diag_score = eval_five(board[0][0],board[1][1],board[2][2],board[3][3],board[4][4]);
+  score[10] = diag_score>0? 10+diag_score : 0;
+
+  diag_score = eval_five(board[4][0],board[3][1],board[2][2],board[1][3],board[0][4]);
+  score[11] = diag_score>0? 10+diag_score : 0;
+
+  int cnt = 0;
+  for (int i=0;i<5;i++)
+    for (int j=0;j<5;j++)
+      if (board[j][i]!=0) cnt++;
+
+  return (cnt==25);	/* true, if end of game */
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*********************************************************************
+ *
+ * score.h - table driven scoring of mathematico lines
+ *
+ * A line is scored by its rank histogram: every card adds a one into a
+ * 3 bit counter of its rank (empty cells add nothing), so the sum over
+ * the cells identifies the line regardless of the order of the cards.
+ * A perfect hash, generated by mkscore from the original rules, maps
+ * the histogram to the hand type. There is no sorting and no branch on
+ * the way.
+ *
+ * The board is SIZE x SIZE, 5 unless the build says otherwise (make
+ * SIZE=6). A line of more than five cells scores its best five cards,
+ * one of four cells scores like five with an empty one. mkscore writes
+ * the tables and the scoring of the lines, unrolled for the size, into
+ * score_tab.c and score_tab.h.
+ */
+
+#ifndef SCORE_H
+#define SCORE_H
+
+#include <stdint.h>
+
+/* board */
+#ifndef SIZE
+#define SIZE	5
+#endif
+#if SIZE<4 || SIZE>7
+#error "SIZE must be 4 to 7"
+#endif
+#define ROWS	SIZE
+#define COLS	SIZE
+#define LINES	(COLS+ROWS+2)	/* order: columns, rows, diag[x][x], diag[x][SIZE-1-x] */
+
+#define RANKS	14		/* 0 for an empty cell, 1..13 for cards */
+#define HANDS	10		/* hand types, see hand_name[] */
+
+/* multipliers of the perfect hash, shared with mkscore */
+#define SCORE_K1		0x9E3779B97F4A7C15ULL
+#define SCORE_K2		0xC2B2AE3D27D4EB4FULL
+
+/* tables, generated by mkscore into score_tab.c */
+extern const uint64_t score_bit[RANKS];
+extern const int hand_score[HANDS];
+extern const int hand_diag_score[HANDS];	/* including the 10 extra points */
+extern const char *hand_name[HANDS];
+
+#ifndef MKSCORE
+
+/* hand_of_hist(), line_hist() and score_board() for SIZE */
+#include "score_tab.h"
+
+/* score of line i with rank histogram h */
+static inline int score_of_hist(int i, uint64_t h) {
+  int t = hand_of_hist(h);
+  return i<COLS+ROWS ? hand_score[t] : hand_diag_score[t];
+}
+
+/* hand type of line i of a board, see LINES for the order */
+static inline int line_hand(const int board[COLS][ROWS], int i) {
+  return hand_of_hist(line_hist(board,i));
+}
+
+/* score of line i of a board */
+static inline int score_line(const int board[COLS][ROWS], int i) {
+  return score_of_hist(i,line_hist(board,i));
+}
+
+#endif
+#endif
@@ -0,0 +1,464 @@
+unit levels;
+
+{ The boards of sokoban and the files of levels they come from.        }
+
+{ A level file is mapped into memory and scanned once for where its    }
+{ levels are. A level is only parsed when it is asked for, so opening  }
+{ a collection of thousands of levels takes no longer than the scan.   }
+
+{ Three formats are read:                                              }
+{ - XSB (or SOK) text, as the public collections come: a level is a    }
+{   block of lines of # wall, space, - or _ floor, . target, $ box,    }
+{   * box on target, @ player, + player on target. Other lines, like   }
+{   titles and comments, separate the levels.                          }
+{ - the binary format of 'sokoban.dat', levels of 19x16 cells, see     }
+{   'decode_map.rb'. A file is taken as binary if it has a NUL byte.   }
+{ - level packs, made from either by 'pack_levels.rb', see there. They }
+{   start with 'SOKP' and have a directory of the levels, so opening   }
+{   one reads no more than the directory. A level's CRC is checked     }
+{   when it is parsed. Levels the compiler left out are empty entries. }
+
+{$MODE OBJFPC}
+
+interface
+
+type
+    CellType = (empty, box, wall);
+    BoardType = record
+      width, height : integer;
+      position : integer;           { of the player, y*width+x }
+      cell : array of CellType;     { width*height cells, row by row }
+      target : array of boolean;
+    end;
+
+{ Map a level file and find its levels, returns their number. Raises   }
+{ an exception if the file can't be read or has no levels.             }
+function OpenLevels (filename: String) : integer;
+
+{ The number of levels of the file opened }
+function LevelCount : integer;
+
+{ Parse level 'nr' (1..LevelCount) into 'board', with arrays of its    }
+{ own. Raises an exception if the level of a pack is damaged, or if    }
+{ the level hasn't one player with walls all around the cells it can   }
+{ reach, so a move never leaves the board.                             }
+procedure GetLevel (nr: integer; var board: BoardType);
+
+implementation
+
+uses
+  baseunix,
+  crc,
+  sysutils;
+
+const
+    DAT_WIDTH  = 19;
+    DAT_HEIGHT = 16;
+    DAT_SIZE   = 2 + DAT_WIDTH*DAT_HEIGHT;    { bytes per level }
+    PACK_MAGIC   = 'SOKP';
+    PACK_VERSION = 1;
+    PACK_HEADER  = 16;                        { bytes before the directory }
+    MIN_RUN      = 3;                         { of a run of cells }
+
+var
+    map : PChar;                { the file }
+    map_size : SizeInt;
+    file_format : (XSB_FORMAT, DAT_FORMAT, PACK_FORMAT);
+    count : integer;
+    first, last : array of SizeInt;   { of level i-1, last excluded }
+    sums : array of longword;         { CRC of level i-1 of a pack }
+
+{ the end of the line at 'pos', without a CR }
+
+function LineEnd (pos: SizeInt) : SizeInt;
+var
+  start : SizeInt;
+begin
+  start := pos;
+  while (pos < map_size) and (map[pos] <> #10) do
+    INC(pos);
+  if (pos > start) and (map[pos-1] = #13) then
+    DEC(pos);
+  LineEnd := pos;
+end;
+
+{ the start of the line after the one at 'pos' }
+
+function NextLine (pos: SizeInt) : SizeInt;
+begin
+  while (pos < map_size) and (map[pos] <> #10) do
+    INC(pos);
+  NextLine := pos+1;
+end;
+
+function IsBoardLine (pos, stop: SizeInt) : boolean;
+var
+  has_wall : boolean;
+begin
+  has_wall := false;
+  IsBoardLine := false;
+  while pos < stop do
+    begin
+      case map[pos] of
+        '#' : has_wall := true;
+        ' ', '-', '_', '.', '$', '*', '@', '+' : ;
+      else
+        exit;
+      end; {case}
+      INC(pos);
+    end;
+  IsBoardLine := has_wall;
+end;
+
+procedure AddLevel (start, stop: SizeInt);
+begin
+  if count = Length(first) then
+    begin
+      SetLength(first,2*count+64);
+      SetLength(last,Length(first));
+    end;
+  first[count] := start;
+  last[count] := stop;
+  INC(count);
+end;
+
+{ the unsigned 32 bit number, little endian, at 'pos' }
+
+function Word32 (pos: SizeInt) : longword;
+begin
+  Word32 := ORD(map[pos]) or (ORD(map[pos+1]) shl 8)
+            or (ORD(map[pos+2]) shl 16) or (longword(ORD(map[pos+3])) shl 24);
+end;
+
+{ the directory of a pack, checked against its CRC }
+
+procedure ScanPack;
+var
+  n, i : longword;
+  sum : longword;
+  start, stop : SizeInt;
+begin
+  if (map_size < PACK_HEADER) or (ORD(map[4]) <> PACK_VERSION) then
+    raise Exception.Create('not a level pack of version ' + IntToStr(PACK_VERSION));
+  n := Word32(8);
+  if (n > (map_size-PACK_HEADER) div 8 - 1) then
+    raise Exception.Create('damaged directory');
+  sum := crc32(0,nil,0);
+  sum := crc32(sum,PByte(map),12);
+  sum := crc32(sum,PByte(map+PACK_HEADER),8*(n+1));
+  if sum <> Word32(12) then
+    raise Exception.Create('damaged directory');
+
+  SetLength(sums,n);
+  i := 0;
+  while i < n do
+    begin
+      start := Word32(PACK_HEADER+8*i);
+      stop := Word32(PACK_HEADER+8*(i+1));
+      if (start < PACK_HEADER+8*(n+1)) or ((stop <> start) and (stop < start+4))
+         or (stop > map_size) then
+        raise Exception.Create('damaged directory');
+      sums[i] := Word32(PACK_HEADER+8*i+4);
+      AddLevel(start,stop);
+      INC(i);
+    end;
+end;
+
+{ one pass over the text, a level is a block of board lines }
+
+procedure ScanText;
+var
+  pos, start : SizeInt;
+  in_level : boolean;
+begin
+  pos := 0;
+  start := 0;
+  in_level := false;
+  while pos < map_size do
+    begin
+      if IsBoardLine(pos,LineEnd(pos)) then
+        begin
+          if not in_level then
+            start := pos;
+          in_level := true;
+        end
+      else if in_level then
+        begin
+          AddLevel(start,pos);
+          in_level := false;
+        end;
+      pos := NextLine(pos);
+    end;
+  if in_level then
+    AddLevel(start,map_size);
+end;
+
+function OpenLevels (filename: String) : integer;
+var
+  fd : longint;
+  info : TStat;
+  pos : SizeInt;
+begin
+  fd := FpOpen(filename,O_RDONLY);
+  if fd < 0 then
+    raise Exception.Create('cannot open it');
+  if (FpFStat(fd,info) <> 0) or (info.st_size = 0) then
+    begin
+      FpClose(fd);
+      raise Exception.Create('no levels in it');
+    end;
+  map_size := info.st_size;
+  map := Fpmmap(nil,map_size,PROT_READ,MAP_SHARED,fd,0);
+  FpClose(fd);
+  if PtrInt(map) = -1 then
+    raise Exception.Create('cannot map it');
+
+  file_format := XSB_FORMAT;
+  if (map_size >= 4) and (StrLComp(map,PACK_MAGIC,4) = 0) then
+    file_format := PACK_FORMAT
+  else
+    begin
+      pos := 0;
+      while (pos < map_size) and (map[pos] <> #0) do
+        INC(pos);
+      if pos < map_size then
+        file_format := DAT_FORMAT;
+    end;
+
+  count := 0;
+  case file_format of
+    PACK_FORMAT : ScanPack;
+    DAT_FORMAT :
+      begin
+        pos := 0;
+        while pos+DAT_SIZE <= map_size do
+          begin
+            AddLevel(pos,pos+DAT_SIZE);
+            INC(pos,DAT_SIZE);
+          end;
+      end;
+    XSB_FORMAT : ScanText;
+  end; {case}
+  if count = 0 then
+    raise Exception.Create('no levels in it');
+  OpenLevels := count;
+end;
+
+function LevelCount : integer;
+begin
+  LevelCount := count;
+end;
+
+procedure GetBinaryLevel (pos: SizeInt; var board: BoardType);
+var
+  j, a : integer;
+begin
+  with board do
+    begin
+      width := DAT_WIDTH;
+      height := DAT_HEIGHT;
+      SetLength(cell,width*height);
+      SetLength(target,width*height);
+      position := ORD(map[pos]) + 256 * ORD(map[pos+1]);
+      for j := 0 to width*height-1 do
+        begin
+          a := ORD(map[pos+2+j]);
+          target[j] := (a=3) or (a=$17);
+          if a=1 then
+            cell[j] := wall
+          else if a>=$14 then
+            cell[j] := box
+          else
+            cell[j] := empty;
+        end;
+    end; {with}
+end;
+
+procedure GetTextLevel (start, stop: SizeInt; var board: BoardType);
+var
+  pos : SizeInt;
+  x, y, players : integer;
+begin
+  with board do
+    begin
+      { the size first: the longest line and the number of lines }
+      width := 0;
+      height := 0;
+      pos := start;
+      while pos < stop do
+        begin
+          if LineEnd(pos)-pos > width then
+            width := LineEnd(pos)-pos;
+          INC(height);
+          pos := NextLine(pos);
+        end;
+      SetLength(cell,width*height);
+      SetLength(target,width*height);
+      for x := 0 to width*height-1 do
+        begin
+          cell[x] := empty;
+          target[x] := false;
+        end;
+      position := -1;
+      players := 0;
+
+      pos := start;
+      for y := 0 to height-1 do
+        begin
+          for x := 0 to LineEnd(pos)-pos-1 do
+            case map[pos+x] of
+              '#' : cell[y*width+x] := wall;
+              '$' : cell[y*width+x] := box;
+              '.' : target[y*width+x] := true;
+              '*' :
+                begin
+                  cell[y*width+x] := box;
+                  target[y*width+x] := true;
+                end;
+              '@' :
+                begin
+                  position := y*width+x;
+                  INC(players);
+                end;
+              '+' :
+                begin
+                  position := y*width+x;
+                  target[y*width+x] := true;
+                  INC(players);
+                end;
+            end; {case}
+          pos := NextLine(pos);
+        end;
+    end; {with}
+  if players > 1 then
+    raise Exception.Create('more than one player');
+end;
+
+{ a level of a pack: the size and the player, then 3 bit codes of the  }
+{ cells and runs of them, read from a window of 16 bits }
+
+procedure GetPackedLevel (start, stop: SizeInt; sum: longword; var board: BoardType);
+var
+  bit, stop_bit : SizeInt;
+  j, n, size : integer;
+
+  function Bits (k: integer) : integer;
+  var
+    w : integer;
+  begin
+    if bit+k > stop_bit then
+      raise Exception.Create('damaged level');
+    w := ORD(map[bit shr 3]);
+    if (bit shr 3)+1 < stop then
+      w := w or (ORD(map[(bit shr 3)+1]) shl 8);
+    Bits := (w shr (bit and 7)) and ((1 shl k)-1);
+    INC(bit,k);
+  end;
+
+  procedure Put (kind: CellType; on_target: boolean; k: integer);
+  begin
+    if j+k > size then
+      raise Exception.Create('damaged level');
+    while k > 0 do
+      begin
+        board.cell[j] := kind;
+        board.target[j] := on_target;
+        INC(j);
+        DEC(k);
+      end;
+  end;
+
+begin
+  if stop = start then
+    raise Exception.Create('left out of the pack');
+  if crc32(crc32(0,nil,0),PByte(map+start),stop-start) <> sum then
+    raise Exception.Create('damaged level');
+  with board do
+    begin
+      width := ORD(map[start]);
+      height := ORD(map[start+1]);
+      position := ORD(map[start+2]) + 256 * ORD(map[start+3]);
+      size := width*height;
+      SetLength(cell,size);
+      SetLength(target,size);
+    end; {with}
+
+  bit := 8*(start+4);
+  stop_bit := 8*stop;
+  j := 0;
+  while j < size do
+    begin
+      n := Bits(3);
+      case n of
+        0 : Put(empty,false,1);
+        1 : Put(wall,false,1);
+        2 : Put(empty,true,1);
+        3 : Put(box,false,1);
+        4 : Put(box,true,1);
+        5 : Put(empty,false,MIN_RUN+Bits(4));
+        6 : Put(wall,false,MIN_RUN+Bits(4));
+      else
+        raise Exception.Create('damaged level');
+      end; {case}
+    end;
+  if board.position >= size then
+    raise Exception.Create('damaged level');
+end;
+
+{ the player on an empty cell, and the cells it can reach, boxes      }
+{ included, away from the edge of the board }
+
+procedure CheckLevel (const board: BoardType);
+var
+  seen : array of boolean;
+  todo : array of integer;
+  n, p, x, y : integer;
+
+  procedure Visit (q: integer);
+  begin
+    if not seen[q] then
+      begin
+        seen[q] := true;
+        todo[n] := q;
+        INC(n);
+      end;
+  end;
+
+begin
+  with board do
+    begin
+      if (position < 0) or (position >= width*height) or (cell[position] <> empty) then
+        raise Exception.Create('no player');
+      SetLength(seen,width*height);
+      SetLength(todo,width*height);
+      for p := 0 to width*height-1 do
+        seen[p] := cell[p] = wall;
+      n := 0;
+      Visit(position);
+      while n > 0 do
+        begin
+          DEC(n);
+          p := todo[n];
+          x := p mod width;
+          y := p div width;
+          if (x = 0) or (y = 0) or (x = width-1) or (y = height-1) then
+            raise Exception.Create('not enclosed by walls');
+          Visit(p-1);
+          Visit(p+1);
+          Visit(p-width);
+          Visit(p+width);
+        end;
+    end; {with}
+end;
+
+procedure GetLevel (nr: integer; var board: BoardType);
+begin
+  case file_format of
+    PACK_FORMAT : GetPackedLevel(first[nr-1],last[nr-1],sums[nr-1],board);
+    DAT_FORMAT : GetBinaryLevel(first[nr-1],board);
+    XSB_FORMAT : GetTextLevel(first[nr-1],last[nr-1],board);
+  end; {case}
+  CheckLevel(board);
+end;
+
+end.
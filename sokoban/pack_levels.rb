@@ -0,0 +1,223 @@
+#!/usr/bin/env ruby
+
+# Compile levels (like 'sokoban.dat', or a collection in XSB format)
+# into a level pack, that sokoban reads like the other formats.
+#
+# Structure of a level pack (all numbers unsigned, little endian)
+#
+# Header of 16 bytes
+# - 4 bytes: "SOKP"
+# - 8 bit: version, 1
+# - 3 bytes: 0
+# - 32 bit: number of levels n
+# - 32 bit: CRC-32 of the first 12 bytes and the directory
+# Directory of n+1 entries of 8 bytes
+# - 32 bit: offset of the level in the file, the last the file size
+# - 32 bit: CRC-32 of the level, 0 in the last entry
+#   A level left out has no bytes, its offset is that of the next one,
+#   so the levels keep the numbers they have in the input.
+# Levels, each trimmed to the walls around it
+# - 8 bit: width
+# - 8 bit: height
+# - 16 bit: player position, y*width+x
+# - the cells row by row, 3 bit codes from the lowest bit of a byte up
+#   - 0	 empty
+#   - 1	 wall
+#   - 2	 target position
+#   - 3	 box
+#   - 4	 box on target position
+#   - 5	 run of empty cells, 4 more bits: length-3
+#   - 6	 run of walls, 4 more bits: length-3
+#   The player's cell is empty or a target. The last byte is padded with
+#   0 bits.
+#
+# Every level is checked before it goes in: it must have one player,
+# walls all around the cells the player can reach, and as many boxes as
+# targets. Levels that fail are reported and left out, sokoban shows
+# them as not playable.
+
+require 'zlib'
+
+MAGIC = "SOKP"
+VERSION = 1
+HEADER = 16
+DAT_SIZE = 306
+DAT_WIDTH = 19
+MIN_RUN = 3
+MAX_RUN = MIN_RUN+15
+CODES = { ' ' => 0, '#' => 1, '.' => 2, '$' => 3, '*' => 4 }
+
+# the levels of sokoban.dat as rows of XSB characters
+
+def read_dat(data)
+  levels = []
+  (0 ... data.length/DAT_SIZE).each do | nr |
+    array = data[nr*DAT_SIZE,DAT_SIZE].unpack "vC304"
+    player_pos = array.shift
+    rows = array.each_slice(DAT_WIDTH).map do | row |
+      row.map do | c |
+	case c
+	when 0x01 then '#'
+	when 0x03 then '.'
+	when 0x14 then '$'
+	when 0x17 then '*'
+	else ' '
+	end
+      end
+    end
+    y, x = player_pos.divmod DAT_WIDTH
+    if y < rows.length then
+      rows[y][x] = (rows[y][x] == '.') ? '+' : '@'
+    end
+    levels << rows
+  end
+  levels
+end
+
+# the levels of an XSB collection, blocks of lines of board characters
+# with at least one wall, as sokoban reads them
+
+def read_xsb(data)
+  levels = []
+  rows = []
+  (data.split(/\r?\n/) + [""]).each do | line |
+    if line =~ /\A[# \-_.$*@+]*\z/ && line.include?('#') then
+      rows << line.tr('-_','  ').chars
+    elsif !rows.empty? then
+      levels << rows
+      rows = []
+    end
+  end
+  levels
+end
+
+# the level trimmed to the cells that aren't empty
+
+def trim(rows)
+  rows = rows.drop_while { | row | row.all? ' ' }
+  rows = rows.reverse.drop_while { | row | row.all? ' ' }.reverse
+  left = rows.map { | row | row.index { | c | c != ' ' } || row.length }.min || 0
+  right = rows.map { | row | row.rindex { | c | c != ' ' } || -1 }.max || -1
+  rows.map do | row |
+    row = row[left .. right] || []
+    row + [' ']*(right-left+1-row.length)
+  end
+end
+
+# the reason the level can't be played, or nil
+
+def check(rows)
+  players = []
+  boxes = targets = 0
+  rows.each_with_index do | row, y |
+    row.each_with_index do | c, x |
+      players << [x,y] if c == '@' || c == '+'
+      boxes += 1 if c == '$' || c == '*'
+      targets += 1 if c == '.' || c == '*' || c == '+'
+    end
+  end
+  return "no player" if players.empty?
+  return "#{players.length} players" if players.length > 1
+  return "boxes: #{boxes}, targets: #{targets}" if boxes != targets
+  return "no boxes" if boxes == 0
+  return "too large" if rows.length > 255 || rows[0].length > 255
+
+  # the cells the player reaches must not get to the border
+  width = rows[0].length
+  seen = rows.flatten.map { | c | c == '#' }
+  todo = [players[0][1]*width+players[0][0]]
+  seen[todo[0]] = true
+  until todo.empty?
+    p = todo.pop
+    y, x = p.divmod width
+    if x == 0 || y == 0 || y == rows.length-1 || x == width-1 then
+      return "not enclosed"
+    end
+    [p-1, p+1, p-width, p+width].each do | q |
+      next if seen[q]
+      seen[q] = true
+      todo << q
+    end
+  end
+  nil
+end
+
+class BitWriter
+  def initialize
+    @bytes = []
+    @acc = 0			# bits not yet in bytes
+    @bits = 0
+  end
+
+  def put(value, n)
+    @acc |= value << @bits
+    @bits += n
+    while @bits >= 8
+      @bytes << (@acc & 0xff)
+      @acc >>= 8
+      @bits -= 8
+    end
+  end
+
+  def flush
+    @bytes << @acc if @bits > 0
+    @bits = @acc = 0
+    @bytes
+  end
+end
+
+def encode(rows)
+  width = rows[0].length
+  cells = rows.flatten
+  player_pos = cells.index { | c | c == '@' || c == '+' }
+  cells[player_pos] = (cells[player_pos] == '+') ? '.' : ' '
+
+  out = BitWriter.new
+  i = 0
+  while i < cells.length
+    run = 1
+    run += 1 while run < MAX_RUN && cells[i+run] == cells[i]
+    if run >= MIN_RUN && (cells[i] == ' ' || cells[i] == '#') then
+      out.put((cells[i] == ' ') ? 5 : 6, 3)
+      out.put(run-MIN_RUN, 4)
+      i += run
+    else
+      out.put(CODES[cells[i]], 3)
+      i += 1
+    end
+  end
+  [width, rows.length, player_pos].pack("CCv") + out.flush.pack("C*")
+end
+
+if ARGV.length != 2 then
+  puts "usage: #{$0} 'sokoban.dat'|'levels.xsb' 'levels.skp'"
+  exit 1
+end
+
+data = File.binread ARGV[0]
+levels = data.include?("\0") ? read_dat(data) : read_xsb(data)
+
+packed = []
+levels.each_with_index do | rows, i |
+  rows = trim(rows)
+  problem = rows.empty? ? "empty" : check(rows)
+  if problem then
+    $stderr.puts "#{ARGV[0]}: level #{i+1} left out, #{problem}"
+    packed << ""
+  else
+    packed << encode(rows)
+  end
+end
+
+offset = HEADER + 8*(packed.length+1)
+directory = packed.map do | level |
+  entry = [offset, level.empty? ? 0 : Zlib.crc32(level)].pack "VV"
+  offset += level.length
+  entry
+end.join + [offset, 0].pack("VV")
+header = MAGIC + [VERSION, 0, 0, 0, packed.length].pack("C4V")
+header += [Zlib.crc32(header + directory)].pack "V"
+
+File.binwrite ARGV[1], header + directory + packed.join
+puts "#{packed.count { | level | !level.empty? }} of #{levels.length} levels, " +
+     "#{data.length} bytes packed into #{offset}"
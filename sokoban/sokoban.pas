@@ -5,6 +5,9 @@ program sokoban;
 { 2.1     2010-04  converted to GNU Modula-2 }
 { 2.1.1   2015-12  english variable names and comments, emacs indentation }
 { 3.0     2015-12  converted to Free Pascal }
+{ 3.1     2026-10  solver, in the menu and as sokosolve }
+{ 3.2     2026-10  level collections in XSB format, boards of any size }
+{ 3.3     2026-10  level packs made by pack_levels.rb }
 
 {  Copyright (c) 1990,2010,2015 Derik van Zuetphen <dz@426.ch> }
 {  All rights reserved. }
@@ -34,29 +37,26 @@ program sokoban;
 
 uses
   crt,
-  classes,
   strutils,
-  sysutils;
+  sysutils,
+  levels,
+  solver;
 
 const
-    OFFSET   = 19;      { corresponds to a size of 19 columns  }
-    MAXPOS   = 303;     { and (303+1)/19 = 16 rows.            }
-    MAXLEVEL = 50;
     esc      = #27;
     del      = #8;
+    WIDE     = 35;      { boards up to 35 columns get two per cell }
+    VIEW_COLUMNS = 71;  { of the screen for the board, from column 10 }
+    VIEW_ROWS    = 18;  { from row 5 }
+
+    { floor, target, wall, box, box on target, player }
+    WIDE_CELLS : array [0 .. 5] of string[2] = ('  ', '..', '##', '[]', '{}', '@@');
+    NARROW_CELLS : array [0 .. 5] of char = (' ', '.', '#', '$', '*', '@');
 
 type
     ActionType = (move_left, move_right, move_up, move_down, undo_move, open_menu);
     ActionSet = set of ActionType;
     ExtendedChar = (no_key, up_key, down_key, right_key, left_key);
-    CellType = (empty, box, wall);
-    Cells = array [0 .. MAXPOS] of CellType;
-    TargetCells = array [0 .. MAXPOS] of boolean;
-    BoardType = record
-      position : integer;
-      cell : Cells;
-      target : TargetCells;
-    end;
     UndoPtr   = ^UndoEntry;
     UndoEntry = record
       action: ActionType;
@@ -67,9 +67,11 @@ type
 var
     action : ActionType;
     end_of_game : boolean;
-    levels : array [1..MAXLEVEL] of BoardType;
     level : BoardType;    { active level }
     num_levels, current_level : integer;
+    cell_width : integer; { screen columns of a cell }
+    view_x, view_y : integer; { top left cell on the screen }
+    level_error : String; { why the level can't be played, if it can't }
     undo : UndoPtr;
 
 procedure ExtRead(var ch: char; var ec: ExtendedChar);
@@ -93,29 +95,38 @@ begin
    end;
 end;
 
-{ Display one cell }
+{ Display one cell, as far as it is on the screen }
 
 procedure DisplayCell (var board: BoardType; pos: integer);
+var
+  x, y, kind : integer;
 begin
-  GotoXY(2*(pos mod OFFSET)+10, pos div OFFSET+5);
   with board do
-    if pos = position then
-      Write('@@')
-    else
-      case cell[pos] of
-        empty:
-          if target[pos] then
-            Write('..')
-          else
-            Write('  ');
-      wall:
-        Write('##');
-      box:
-        if target[pos] then
-          Write('{}')
-        else
-          Write('[]')
-      end; {case}
+    begin
+      x := cell_width*(pos mod width-view_x)+10;
+      y := pos div width-view_y+5;
+      if (x < 10) or (x+cell_width-1 > 9+VIEW_COLUMNS)
+         or (y < 5) or (y > 4+VIEW_ROWS) then
+        exit;
+
+      if pos = position then
+        kind := 5
+      else
+        case cell[pos] of
+          empty:
+            if target[pos] then kind := 1 else kind := 0;
+          wall:
+            kind := 2;
+          box:
+            if target[pos] then kind := 4 else kind := 3;
+        end; {case}
+    end; {with}
+
+  GotoXY(x,y);
+  if cell_width = 2 then
+    Write(WIDE_CELLS[kind])
+  else
+    Write(NARROW_CELLS[kind]);
 end;
 
 { Display the complete board }
@@ -124,20 +135,58 @@ procedure DisplayBoard (var board: BoardType);
 var
   i : integer;
 BEGIN
-  GotoXY(10,3);
-  write('                             '); { delete line }
-  for i := 0 to MAXPOS do
+  ClrScr;
+  GotoXY(29,2);
+  Write('---  S O K O B A N  ---');
+  for i := 0 to High(board.cell) do
     begin
       DisplayCell(board,i);
     end;
   GotoXY(10,3);
   write('Nr. ');
-  write(current_level:2);
+  write(current_level:2,' of ',num_levels);
+  if level_error <> '' then
+    write('   cannot be played: ',level_error);
   GotoXY(2,23);
   write('Cursor keys to move, Del to undo, ESC for menu');
   GotoXY(1,1);
 end;
 
+{ Move the view, if the player comes near its edge. A board larger    }
+{ than the screen scrolls by half a screen. Returns true, if the view  }
+{ has moved.                                                           }
+
+function Follow1 (view, size, board_size, pos: integer) : integer;
+begin
+  if size >= board_size then
+    Follow1 := 0
+  else if (pos >= view+2) and (pos < view+size-2) then
+    Follow1 := view
+  else
+    begin
+      view := pos - size div 2;
+      if view < 0 then
+        view := 0;
+      if view > board_size-size then
+        view := board_size-size;
+      Follow1 := view;
+    end;
+end;
+
+function Follow (var board: BoardType) : boolean;
+var
+  x, y : integer;
+begin
+  with board do
+    begin
+      x := Follow1(view_x,VIEW_COLUMNS div cell_width,width,position mod width);
+      y := Follow1(view_y,VIEW_ROWS,height,position div width);
+    end; {with}
+  Follow := (x <> view_x) or (y <> view_y);
+  view_x := x;
+  view_y := y;
+end;
+
 { Perform 'action' on 'board' }
 
 procedure Move (var board: BoardType; action: ActionType);
@@ -158,6 +207,8 @@ var
   end;
 
 begin
+  if level_error <> '' then
+    exit;
   with board do
     if action = undo_move then
       begin
@@ -169,9 +220,9 @@ begin
               move_right:
                 diff := 1;
               move_up:
-                diff := -OFFSET;
+                diff := -width;
               move_down:
-                diff := OFFSET;
+                diff := width;
             end; {case}
 
             if undo^.pushed then
@@ -197,9 +248,9 @@ begin
           move_right:
             diff := 1;
           move_up:
-            diff := -OFFSET;
+            diff := -width;
           move_down:
-            diff := OFFSET;
+            diff := width;
         end; {case}
 
         if cell [position+diff] = empty then
@@ -222,6 +273,8 @@ begin
                 AddUndo(action,TRUE);
               end;
     end; {if action <> undo_move}
+  if Follow(board) then
+    DisplayBoard(board);
   GotoXY(1,1);
 end;
 
@@ -290,7 +343,28 @@ begin
       undo := undo^.next;
       DISPOSE (local_undo);
     end;
-  level := levels[current_level];
+  level_error := '';
+  try
+    GetLevel(current_level,level);
+  except
+    on e:Exception do
+      begin
+        { shown instead of the board, the other levels can still be played }
+        level_error := e.message;
+        level.width := 0;
+        level.height := 0;
+        SetLength(level.cell,0);
+        SetLength(level.target,0);
+      end;
+  end; {try}
+  if level.width <= WIDE then
+    cell_width := 2
+  else
+    cell_width := 1;
+  view_x := 0;
+  view_y := 0;
+  if level_error = '' then
+    Follow(level);
   DisplayBoard (level);
 end;
 
@@ -341,44 +415,9 @@ begin
 end;
 
 procedure LoadLevel(filename: String);
-var
-  i,j,a : integer;
-  by1, by2 : byte;
-  input_file : TFileStream;
 begin
   try
-    filename := GetExecutableDir + DirectorySeparator + filename;
-    input_file := TFileStream.Create(filename,fmOpenRead);
-
-    num_levels := 50; { there a 50 levels in sokoban.dat, see 'decode_map.rb' }
-
-    for i := 1 to num_levels do
-      begin
-        with levels[i] do
-          begin
-            by1 := input_file.ReadByte;
-            by2 := input_file.ReadByte;
-            position := ORD(by1) + 256 * ORD(by2);
-
-            for j := 0 to MAXPOS do
-              begin
-                by1 := input_file.ReadByte;
-                a := ORD(by1);
-                if (a=3) or (a=$17) then
-                  target[j] := true
-                else
-                  target[j] := FALSE;
-
-                if (a=0) or (a=3) then
-                  cell[j] := empty
-                else if a=1 then
-                  cell[j] := wall
-                else if a>=$14 then
-                  cell[j] := box;
-              end;
-          end; {with}
-      end; {while}
-
+    num_levels := OpenLevels(filename);
   except
     on e:Exception do
       begin
@@ -398,10 +437,72 @@ begin
    Write('---  S O K O B A N  ---');
    end_of_game := FALSE;
    undo := NIL;
-   LoadLevel('sokoban.dat');
+   if ParamCount >= 1 then
+     LoadLevel(ParamStr(1))
+   else
+     LoadLevel(GetExecutableDir + DirectorySeparator + 'sokoban.dat');
    GotoLevel(1);
 end;
 
+{ Solve the level from where the player is, and show the solution move }
+{ by move if wanted. Its moves can be undone like the player's.         }
+
+procedure SolveLevel (x, y: integer);
+var
+  answer : SolveResult;
+  ch : char;
+  ec : ExtendedChar;
+  i : integer;
+begin
+  GotoXY(x,y);    Write('Solving ...');
+  answer := Solve(level,SOLVER_NODES,SOLVER_TABLE_BITS);
+  GotoXY(x,y);
+  case answer.status of
+    solved :
+      begin
+        Write(answer.pushes,' pushes, ',Length(answer.moves),' moves');
+        GotoXY(x,y+2); Write('Show them (Y/N)?_');
+        ExtRead(ch,ec);
+        if UpCase(ch) = 'Y' then
+          for i := 1 to Length(answer.moves) do
+            begin
+              case answer.moves[i] of
+                'l', 'L' : Move(level, move_left);
+                'r', 'R' : Move(level, move_right);
+                'u', 'U' : Move(level, move_up);
+                'd', 'D' : Move(level, move_down);
+              end; {case}
+              Delay(100);
+              if KeyPressed then
+                begin
+                  ExtRead(ch,ec); { the key stops the replay, it is no move }
+                  break;
+                end;
+            end;
+      end;
+    unsolvable :
+      begin
+        Write('Not solvable from here.');
+        GotoXY(x,y+2); Write('Press a key_');
+        ExtRead(ch,ec);
+      end;
+    gave_up :
+      begin
+        Write('No solution in ',answer.nodes div 1000,'k');
+        GotoXY(x,y+1); Write('positions.');
+        GotoXY(x,y+2); Write('Press a key_');
+        ExtRead(ch,ec);
+      end;
+  end; {case}
+
+  for i := y to y+2 do
+    begin
+      GotoXY(x,i);
+      Write('                             ');
+    end;
+  GotoXY(1,1);
+end;
+
 procedure DisplayMenu;
 const
    x = 50;
@@ -417,8 +518,9 @@ begin
    GotoXY(x,y+5);  Write('P .... Previous Level');
    GotoXY(x,y+7);  Write('G .... Goto Level');
    GotoXY(x,y+9);  Write('R .... Reset Level');
-   GotoXY(x,y+11); Write('Q .... Quit Sokoban');
-   GotoXY(x,y+13); Write('Choice:_');
+   GotoXY(x,y+11); Write('S .... Solve');
+   GotoXY(x,y+13); Write('Q .... Quit Sokoban');
+   GotoXY(x,y+15); Write('Choice:_');
 
    ExtRead(wahl,ec);
    wahl := UpCase(wahl);
@@ -428,22 +530,33 @@ begin
      'P' : DEC(current_level);
      'G' :
        begin
-        GotoXY(x,y+16); Write('Enter Level: ');
+        GotoXY(x,y+17); Write('Enter Level: ');
         Read(wert);
         current_level := wert;
        end;
      'R' : begin end; { nothing, simply execute GotoLevel() }
+     'S' : begin end; { after the menu is gone }
      'Q' : end_of_game := true;
    end; {case}
 
-   for i := y to y+16 do
+   for i := y to y+17 do
       begin
         GotoXY(x,i);
         Write('                             ');
       end;
 
    if (wahl='N') or (wahl='P') or (wahl='G') or (wahl='R') then
-      GotoLevel(current_level);
+      GotoLevel(current_level)
+   else if not end_of_game then
+      begin
+        { the menu may have covered a wide board }
+        DisplayBoard(level);
+        if (wahl='S') and (level_error = '') then
+          begin
+            SolveLevel(x,y);
+            DisplayBoard(level);
+          end;
+      end;
 end;
 
 { main program }
@@ -0,0 +1,136 @@
+program sokosolve;
+
+{ Solve the levels of sokoban.dat, of a collection in XSB format or of }
+{ a level pack, in a batch.                                            }
+
+{ Usage: sokosolve [-n nodes] [-t bits] [file [level ...]]             }
+
+{ Solves the levels given, all by default, from their start with at    }
+{ most 'nodes' positions (1000000) and a table of 2^bits positions     }
+{ (20), and prints for each level the pushes and moves of the solution }
+{ found, the positions searched per second and the memory used.        }
+{ The solutions go to the end of the output, one line per level.       }
+
+{$MODE OBJFPC}
+
+uses
+  strutils,
+  sysutils,
+  levels,
+  solver;
+
+const
+    STATUS_NAME : array [SolveStatus] of String = ('solved', 'unsolvable', 'gave up');
+
+var
+    board : BoardType;
+    wanted : array of integer;        { level numbers, in order }
+    solutions : array of AnsiString;  { of the wanted levels }
+    answer : SolveResult;
+    filename, error : String;
+    max_nodes : int64;
+    table_bits, num_levels, i, n, count : integer;
+    total : double;
+
+procedure Usage;
+begin
+  writeln('usage: sokosolve [-n nodes] [-t bits] [file [level ...]]');
+  halt(1);
+end;
+
+begin
+  filename := 'sokoban.dat';
+  max_nodes := SOLVER_NODES;
+  table_bits := SOLVER_TABLE_BITS;
+
+  i := 1;
+  while (i <= ParamCount) and (LeftStr(ParamStr(i),1) = '-') do
+    begin
+      if i = ParamCount then
+        Usage;
+      if ParamStr(i) = '-n' then
+        max_nodes := StrToInt64Def(ParamStr(i+1),0)
+      else if ParamStr(i) = '-t' then
+        table_bits := StrToIntDef(ParamStr(i+1),0)
+      else
+        Usage;
+      i := i+2;
+    end;
+  if (max_nodes < 1) or (table_bits < 1) or (table_bits > 30) then
+    Usage;
+  if i <= ParamCount then
+    begin
+      filename := ParamStr(i);
+      INC(i);
+    end;
+  SetLength(wanted,ParamCount-i+1);
+  for n := 0 to High(wanted) do
+    begin
+      wanted[n] := StrToIntDef(ParamStr(i+n),0);
+      if wanted[n] < 1 then
+        Usage;
+    end;
+
+  try
+    num_levels := OpenLevels(filename);
+  except
+    on e:Exception do
+      begin
+        writeln(filename,': ', e.message);
+        halt(1);
+      end;
+  end; {try}
+  if Length(wanted) = 0 then
+    begin
+      SetLength(wanted,num_levels);
+      for n := 0 to num_levels-1 do
+        wanted[n] := n+1;
+    end;
+  SetLength(solutions,Length(wanted));
+
+  writeln('level  result    pushes  moves     nodes  seconds   nodes/s  memory kB');
+  count := 0;
+  total := 0;
+  for n := 0 to High(wanted) do
+    begin
+      if wanted[n] > num_levels then
+        begin
+          writeln(wanted[n]:5, '  not in ', filename);
+          continue;
+        end;
+      error := '';
+      try
+        GetLevel(wanted[n],board);
+      except
+        on e:Exception do
+          error := e.message;
+      end; {try}
+      if error <> '' then
+        begin
+          writeln(wanted[n]:5, '  ', error);
+          continue;
+        end;
+      answer := Solve(board,max_nodes,table_bits);
+      with answer do
+        begin
+          if status = solved then
+            INC(count);
+          total := total + seconds;
+          solutions[n] := moves;
+          write(wanted[n]:5, '  ', PadRight(STATUS_NAME[status],10), pushes:6, Length(moves):7,
+                nodes:10, seconds:9:2);
+          if seconds > 0 then
+            write(nodes/seconds:10:0)
+          else
+            write('-':10);
+          writeln(memory div 1024:11);
+        end;
+    end;
+  writeln;
+  writeln(count, ' solved in ', total:0:2, ' s');
+
+  writeln;
+  for n := 0 to High(wanted) do
+    if solutions[n] <> '' then
+      writeln(wanted[n]:5, '  ', solutions[n]);
+end.
@@ -0,0 +1,561 @@
+unit solver;
+
+{ A solver for a board of sokoban, shared by sokoban and sokosolve.     }
+
+{ The solver searches pushes, not moves: a position is the boxes and  }
+{ the cells the player can reach without pushing, named by the        }
+{ smallest of them. The search is IDA*, the lower bound of the pushes  }
+{ still needed is the cheapest matching of boxes to targets (Hungarian }
+{ method) over the pushes a box would need to each target on an empty  }
+{ board. A solution is the shortest in pushes.                         }
+
+{ Positions are hashed incrementally (Zobrist keys per box cell and    }
+{ per player cell) into a transposition table of a fixed size, which   }
+{ keeps the pushes a position was reached with in the current round.   }
+{ A push onto a dead cell, from where no target can be reached, or one }
+{ that freezes boxes off their targets is never made.                  }
+
+{$MODE OBJFPC}
+
+interface
+
+uses
+  levels;
+
+const
+    SOLVER_NODES = 1000000;     { positions searched before giving up }
+    SOLVER_TABLE_BITS = 20;     { 2^20 positions in the table }
+
+type
+    SolveStatus = (solved, unsolvable, gave_up);
+    SolveResult = record
+      status : SolveStatus;
+      pushes : integer;
+      moves : AnsiString;   { l, r, u, d, upper case for a push }
+      nodes : int64;        { positions searched }
+      seconds : double;
+      memory : int64;       { bytes used by the solver }
+    end;
+
+{ Solve 'board' from where the player is, searching at most 'nodes'    }
+{ positions with a table of 2^table_bits of them.                      }
+function Solve (const board: BoardType; nodes: int64; table_bits: integer) : SolveResult;
+
+implementation
+
+uses
+  sysutils;
+
+const
+    NOWHERE  = -1;
+    INFINITE = 100000;      { pushes to a target that can't be reached }
+    BIG      = 1000000000;  { larger than any bound }
+    FOUND    = -1;          { returned by Search() }
+    MAXBOXES = 64;
+
+type
+    Direction = 0 .. 3;
+    CellSet = array of boolean;
+    TableEntry = record
+      key : qword;
+      pushes : integer;     { the position was reached with }
+      iteration : integer;  { of IDA* }
+    end;
+
+const
+    OPPOSITE : array [Direction] of Direction = (1, 0, 3, 2);
+    LETTERS : array [Direction] of char = ('l', 'r', 'u', 'd');
+
+var
+    columns, size : integer;    { of the board }
+    walls : CellSet;            { also boxes that are frozen, see Frozen() }
+    boxes : CellSet;
+    goals : CellSet;
+    dead : CellSet;
+    targets : array [0 .. MAXBOXES-1] of integer;
+    num_targets : integer;
+    distance : array [0 .. MAXBOXES-1] of array of integer;
+    box_key, player_key : array of qword;
+    queue, came : array of integer;   { for the searches of the player }
+    reach_sets : array of CellSet;    { Reach() of every push of the path }
+    table : array of TableEntry;
+    table_mask : qword;
+    iteration : integer;
+    node_count, node_limit : int64;
+    push_box : array of integer;      { the pushes of the current path }
+    push_dir : array of Direction;
+    solution_length : integer;
+    seed : qword;
+
+{ The cell next to 'pos' in direction 'dir' (left, right, up, down), }
+{ NOWHERE at the edge of the board }
+
+function Step (pos: integer; dir: Direction) : integer;
+begin
+  Step := NOWHERE;
+  if pos = NOWHERE then
+    exit;
+  case dir of
+    0: if pos mod columns > 0 then Step := pos-1;
+    1: if pos mod columns < columns-1 then Step := pos+1;
+    2: if pos >= columns then Step := pos-columns;
+    3: if pos+columns < size then Step := pos+columns;
+  end; {case}
+end;
+
+function IsFloor (pos: integer) : boolean;
+begin
+  IsFloor := (pos <> NOWHERE) and not walls[pos];
+end;
+
+function NextKey : qword;
+begin
+  seed := seed xor (seed shl 13);
+  seed := seed xor (seed shr 7);
+  seed := seed xor (seed shl 17);
+  NextKey := seed;
+end;
+
+{ The pushes from every cell to every target on an empty board, by     }
+{ pulling a box away from the target. Cells that reach no target are   }
+{ dead. }
+
+procedure FindDistances;
+var
+  t, head, tail, pos, n : integer;
+  d : Direction;
+begin
+  for t := 0 to num_targets-1 do
+    begin
+      SetLength(distance[t],size);
+      for pos := 0 to size-1 do
+        distance[t][pos] := INFINITE;
+      distance[t][targets[t]] := 0;
+      queue[0] := targets[t];
+      head := 0;
+      tail := 1;
+      while head < tail do
+        begin
+          pos := queue[head];
+          INC(head);
+          for d := 0 to 3 do
+            begin
+              n := Step(pos,d);
+              if IsFloor(n) and IsFloor(Step(n,d)) and (distance[t][n] = INFINITE) then
+                begin
+                  distance[t][n] := distance[t][pos]+1;
+                  queue[tail] := n;
+                  INC(tail);
+                end;
+            end;
+        end; {while}
+    end; {for}
+
+  for pos := 0 to size-1 do
+    begin
+      dead[pos] := true;
+      for t := 0 to num_targets-1 do
+        if distance[t][pos] < INFINITE then
+          dead[pos] := false;
+    end;
+end;
+
+{ The cells the player can reach from 'pos' without pushing, returns   }
+{ the smallest one, which stands for all of them in a position }
+
+function Reach (pos: integer; var seen: CellSet) : integer;
+var
+  head, tail, least, n : integer;
+  d : Direction;
+begin
+  FillChar(seen[0],size,0);
+  seen[pos] := true;
+  queue[0] := pos;
+  head := 0;
+  tail := 1;
+  least := pos;
+  while head < tail do
+    begin
+      pos := queue[head];
+      INC(head);
+      for d := 0 to 3 do
+        begin
+          n := Step(pos,d);
+          if IsFloor(n) and not boxes[n] and not seen[n] then
+            begin
+              seen[n] := true;
+              queue[tail] := n;
+              INC(tail);
+              if n < least then
+                least := n;
+            end;
+        end;
+    end; {while}
+  Reach := least;
+end;
+
+{ The least pushes to bring every box onto a target of its own,        }
+{ INFINITE or more if there is no way. Hungarian method, boxes are the  }
+{ rows and targets the columns, there are at least as many targets.    }
+
+function LowerBound : integer;
+var
+  at : array [1 .. MAXBOXES] of integer;
+  u, v, minv, p, way : array [0 .. MAXBOXES] of integer;
+  used : array [0 .. MAXBOXES] of boolean;
+  n, i, j, i0, j0, j1, delta, cost, pos : integer;
+begin
+  n := 0;
+  for pos := 0 to size-1 do
+    if boxes[pos] then
+      begin
+        INC(n);
+        at[n] := pos;
+      end;
+  for j := 0 to num_targets do
+    begin
+      u[j] := 0;
+      v[j] := 0;
+      p[j] := 0;
+      way[j] := 0;
+    end;
+
+  for i := 1 to n do
+    begin
+      p[0] := i;
+      j0 := 0;
+      for j := 0 to num_targets do
+        begin
+          minv[j] := BIG;
+          used[j] := false;
+        end;
+      repeat
+        used[j0] := true;
+        i0 := p[j0];
+        delta := BIG;
+        j1 := 0;
+        for j := 1 to num_targets do
+          if not used[j] then
+            begin
+              cost := distance[j-1][at[i0]] - u[i0] - v[j];
+              if cost < minv[j] then
+                begin
+                  minv[j] := cost;
+                  way[j] := j0;
+                end;
+              if minv[j] < delta then
+                begin
+                  delta := minv[j];
+                  j1 := j;
+                end;
+            end;
+        for j := 0 to num_targets do
+          if used[j] then
+            begin
+              INC(u[p[j]],delta);
+              DEC(v[j],delta);
+            end
+          else
+            DEC(minv[j],delta);
+        j0 := j1;
+      until p[j0] = 0;
+      repeat
+        j1 := way[j0];
+        p[j0] := p[j1];
+        j0 := j1;
+      until j0 = 0;
+    end; {for}
+  LowerBound := -v[0];
+end;
+
+{ Freeze deadlocks: a box is frozen if it can move neither left or     }
+{ right nor up or down. It can't on an axis, if there is a wall on     }
+{ either side, dead cells on both sides, or a frozen box on either     }
+{ side, for which the box itself counts as a wall. 'on_target' is      }
+{ cleared, if a frozen box is not on a target. }
+
+function Frozen (pos: integer; var on_target: boolean) : boolean; forward;
+
+function Blocked (pos: integer; d1, d2: Direction; var on_target: boolean) : boolean;
+var
+  n1, n2 : integer;
+  on1, on2 : boolean;
+begin
+  n1 := Step(pos,d1);
+  n2 := Step(pos,d2);
+  if not IsFloor(n1) or not IsFloor(n2) or (dead[n1] and dead[n2]) then
+    Blocked := true
+  else
+    begin
+      walls[pos] := true;
+      on1 := true;
+      on2 := true;
+      if boxes[n1] and Frozen(n1,on1) then
+        begin
+          Blocked := true;
+          on_target := on_target and on1;
+        end
+      else if boxes[n2] and Frozen(n2,on2) then
+        begin
+          Blocked := true;
+          on_target := on_target and on2;
+        end
+      else
+        Blocked := false;
+      walls[pos] := false;
+    end;
+end;
+
+function Frozen (pos: integer; var on_target: boolean) : boolean;
+var
+  all_on, stuck : boolean;
+begin
+  all_on := goals[pos];
+  stuck := Blocked(pos,0,1,all_on) and Blocked(pos,2,3,all_on);
+  if stuck and not all_on then
+    on_target := false;
+  Frozen := stuck;
+end;
+
+{ One node of IDA*: returns FOUND, or the least bound above 'bound'    }
+{ of the positions cut off, BIG if there are none. }
+
+function Search (player: integer; boxes_key: qword; pushes, bound: integer) : integer;
+var
+  pos, n, from, f, t, best : integer;
+  i : int64;
+  key : qword;
+  d : Direction;
+  on_target : boolean;
+begin
+  INC(node_count);
+  if node_count > node_limit then
+    begin
+      Search := BIG;
+      exit;
+    end;
+
+  f := LowerBound;
+  if f >= INFINITE then
+    begin
+      Search := BIG;
+      exit;
+    end;
+  if f = 0 then
+    begin
+      solution_length := pushes;
+      Search := FOUND;
+      exit;
+    end;
+  if pushes+f > bound then
+    begin
+      Search := pushes+f;
+      exit;
+    end;
+
+  if pushes >= Length(push_box) then
+    begin
+      SetLength(push_box,2*Length(push_box)+64);
+      SetLength(push_dir,Length(push_box));
+      SetLength(reach_sets,Length(push_box));
+    end;
+  if Length(reach_sets[pushes]) <> size then
+    SetLength(reach_sets[pushes],size);
+
+  { been here in this round with as few pushes? }
+  key := boxes_key xor player_key[Reach(player,reach_sets[pushes])];
+  i := int64(key and table_mask);
+  if (table[i].key = key) and (table[i].iteration = iteration) and (table[i].pushes <= pushes) then
+    begin
+      Search := BIG;
+      exit;
+    end;
+  table[i].key := key;
+  table[i].iteration := iteration;
+  table[i].pushes := pushes;
+
+  best := BIG;
+  for pos := 0 to size-1 do
+    if boxes[pos] and (node_count <= node_limit) then
+      for d := 0 to 3 do
+        begin
+          from := Step(pos,OPPOSITE[d]);
+          n := Step(pos,d);
+          if (from = NOWHERE) or not reach_sets[pushes][from] or not IsFloor(n) or boxes[n] or dead[n] then
+            continue;
+
+          boxes[pos] := false;
+          boxes[n] := true;
+          on_target := true;
+          if Frozen(n,on_target) and not on_target then
+            t := BIG
+          else
+            begin
+              push_box[pushes] := pos;
+              push_dir[pushes] := d;
+              t := Search(pos,boxes_key xor box_key[pos] xor box_key[n],pushes+1,bound);
+            end;
+          boxes[n] := false;
+          boxes[pos] := true;
+
+          if t = FOUND then
+            begin
+              Search := FOUND;
+              exit;
+            end;
+          if t < best then
+            best := t;
+        end;
+  Search := best;
+end;
+
+{ The moves of the player from 'pos' to 'goal' without pushing }
+
+function Walk (pos, goal: integer) : AnsiString;
+var
+  seen : CellSet;
+  head, tail, n : integer;
+  d : Direction;
+  path : AnsiString;
+begin
+  SetLength(seen,size);
+  FillChar(seen[0],size,0);
+  seen[pos] := true;
+  queue[0] := pos;
+  head := 0;
+  tail := 1;
+  while (head < tail) and not seen[goal] do
+    begin
+      n := queue[head];
+      INC(head);
+      for d := 0 to 3 do
+        if IsFloor(Step(n,d)) and not boxes[Step(n,d)] and not seen[Step(n,d)] then
+          begin
+            seen[Step(n,d)] := true;
+            came[Step(n,d)] := d;
+            queue[tail] := Step(n,d);
+            INC(tail);
+          end;
+    end; {while}
+
+  path := '';
+  while goal <> pos do
+    begin
+      d := came[goal];
+      path := LETTERS[d] + path;
+      goal := Step(goal,OPPOSITE[d]);
+    end;
+  Walk := path;
+end;
+
+function Solve (const board: BoardType; nodes: int64; table_bits: integer) : SolveResult;
+var
+  answer : SolveResult;
+  start : TDateTime;
+  pos, num_boxes, num_goals, bound, t, k : integer;
+  boxes_key : qword;
+  d : Direction;
+begin
+  start := Now;
+  answer.status := unsolvable;
+  answer.pushes := 0;
+  answer.moves := '';
+  answer.nodes := 0;
+
+  num_targets := 0;
+  num_goals := 0;
+  num_boxes := 0;
+  boxes_key := 0;
+  seed := 88172645463325252;
+  columns := board.width;
+  size := board.width*board.height;
+  SetLength(walls,size);
+  SetLength(boxes,size);
+  SetLength(goals,size);
+  SetLength(dead,size);
+  SetLength(box_key,size);
+  SetLength(player_key,size);
+  SetLength(queue,size);
+  SetLength(came,size);
+  for pos := 0 to size-1 do
+    begin
+      walls[pos] := board.cell[pos] = wall;
+      boxes[pos] := board.cell[pos] = box;
+      goals[pos] := board.target[pos];
+      box_key[pos] := NextKey;
+      player_key[pos] := NextKey;
+      if boxes[pos] then
+        begin
+          INC(num_boxes);
+          boxes_key := boxes_key xor box_key[pos];
+        end;
+      if goals[pos] then
+        begin
+          if num_goals < MAXBOXES then
+            targets[num_goals] := pos;
+          INC(num_goals);
+        end;
+    end;
+
+  SetLength(table,int64(1) shl table_bits);
+  FillChar(table[0],Length(table)*SizeOf(TableEntry),0);
+  table_mask := Length(table)-1;
+  answer.memory := Length(table)*SizeOf(TableEntry)
+                   + int64(size)*(4 + 2*SizeOf(qword) + 2*SizeOf(integer));
+
+  { more boxes than targets can't be solved, more than MAXBOXES aren't }
+  num_targets := num_goals;
+  if num_goals > MAXBOXES then
+    begin
+      num_targets := MAXBOXES;
+      answer.status := gave_up;
+    end
+  else if num_boxes <= num_targets then
+    begin
+      FindDistances;
+      node_count := 0;
+      node_limit := nodes;
+      iteration := 0;
+      bound := LowerBound;
+      t := 0;
+      while (bound < INFINITE) and (t <> FOUND) do
+        begin
+          INC(iteration);
+          t := Search(board.position,boxes_key,0,bound);
+          if node_count > node_limit then
+            break;
+          bound := t;
+        end;
+
+      answer.nodes := node_count;
+      if t = FOUND then
+        answer.status := solved
+      else if node_count > node_limit then
+        answer.status := gave_up;
+    end;
+
+  { the moves of the pushes found, from the board again }
+  if answer.status = solved then
+    begin
+      for pos := 0 to size-1 do
+        boxes[pos] := board.cell[pos] = box;
+      pos := board.position;
+      for k := 0 to solution_length-1 do
+        begin
+          d := push_dir[k];
+          answer.moves := answer.moves + Walk(pos,Step(push_box[k],OPPOSITE[d])) + UpCase(LETTERS[d]);
+          pos := push_box[k];
+          boxes[pos] := false;
+          boxes[Step(pos,d)] := true;
+        end;
+      answer.pushes := solution_length;
+    end;
+
+  answer.memory := answer.memory + int64(num_targets)*size*SizeOf(integer)
+                   + Length(push_box)*(SizeOf(integer)+SizeOf(Direction)+size);
+  SetLength(table,0);
+  answer.seconds := (Now-start)*SecsPerDay;
+  Solve := answer;
+end;
+
+end.